@@ -0,0 +1,68 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "timebase.h"
+
+//
+//                            --A--
+//                         F |     | B
+//                           |--G--|
+//                         E |     | C
+//                            --D--
+//
+// сегменты     {A,   B,   C,   D,    E,    F,   G}
+// выводы       {6,   8,   9,   11,   10,   5,   7}
+// порт         {PD6, PB0, PB1, PB3,  PB2,  PD5, PD7}
+// разряды: gnd1 = 3 (PD3), gnd2 = 4 (PD4)
+//
+// Динамическая индикация ведётся в прерывании TIMER1_COMPA, следующий
+// момент прерывания задаётся сдвигом OCR1A (см. timebase.h).
+// Яркость - двоично-взвешенная модуляция (BCM): время разряда делится на
+// DISP_BCM_BITS отрезков длиной 1, 2, 4, 8... единиц, и разряд горит в тех
+// отрезках, чей бит установлен в уровне яркости. Частота обновления от
+// яркости не зависит, прерываний на разряд ровно DISP_BCM_BITS.
+
+#define DISP_DIGIT_US 1000         // период одного разряда, мкс
+#define DISP_DIGIT_TICKS TIMEBASE_US(DISP_DIGIT_US)
+#define DISP_BCM_BITS 4
+#define DISP_BRIGHT_MAX ((1 << DISP_BCM_BITS) - 1)
+#define DISP_SLICE_TICKS (DISP_DIGIT_TICKS / DISP_BRIGHT_MAX) // самый короткий отрезок
+#define DISP_LOAD_DIGITS 64        // окно измерения загрузки, периодов разряда
+
+// Текст выводится шрифтом из flash (ASCII 0x20..0x5F, строчные буквы
+// рисуются как прописные). Строки длиннее двух символов прокручиваются
+// бегущей строкой по одному символу за DISP_SCROLL_MS из displayTick(),
+// сообщения ждут своей очереди. Любой другой вывод прерывает прокрутку
+// и очищает очередь, после прокрутки возвращается прежнее изображение.
+#define DISP_SCROLL_MS 300
+#define DISP_QUEUE 4               // сообщений в очереди
+
+typedef struct {
+  //          GFEDCBA
+  byte d1 = B01000000;
+  byte d2 = B01000000;
+} dispStruct;
+
+void displayInit();
+void displaySet(byte d1, byte d2);
+dispStruct displayGet();
+// сегменты символа, для неизвестных пусто
+byte displayGlyph(char c);
+// первые два символа строки
+void displayText(const char *s);
+void displayText_P(PGM_P s);
+// -9..99, десятки гасятся, минус в первом разряде
+void displayNumber(int n);
+// поставить строку из flash в очередь бегущих строк, false если очередь полна
+bool displayScroll_P(PGM_P s);
+bool displayScrolling();
+// вызывать из loop()
+void displayTick();
+// погасить индикацию и остановить развёртку (перед сном)
+void displayOff();
+void displayOn();
+// уровень 0..DISP_BRIGHT_MAX, применяется с ближайшего отрезка
+void displaySetBrightness(byte level);
+// доля времени МК в прерывании индикации за последнее окно, 1/1000
+// (без входа и выхода из прерывания, около 40 тактов на каждое)
+uint16_t displayLoad();
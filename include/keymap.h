@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+
+#define KEY_UNDEFINED 0
+#define KEY_REPEAT    1
+#define KEY_MUTE      2
+#define KEY_VOL_UP    3
+#define KEY_VOL_DOWN  4
+#define KEY_BASS_UP   5
+#define KEY_BASS_DOWN 6
+#define KEY_TREB_UP   7
+#define KEY_TREB_DOWN 8
+#define KEY_INPUT_CH  9
+#define KEY_RESET     10
+#define KEY_COUNT     11
+#define KEY_MACRO     16 // KEY_MACRO + n запускает макрос n, см. macro.h
+
+// пульты, коды которых попадают в прошивку
+#define REMOTE_ANY    0 // общие коды (повтор NEC)
+#define REMOTE_CAR_MP3 1 // китайский NEC пульт
+#define REMOTE_SOLO7C 2 // оригинальный пульт Solo 7C
+
+// набор пультов задаётся маской, например -D KEYMAP_REMOTES=_BV(REMOTE_SOLO7C)
+#ifndef KEYMAP_REMOTES
+#define KEYMAP_REMOTES (_BV(REMOTE_CAR_MP3) | _BV(REMOTE_SOLO7C))
+#endif
+
+// выученные коды хранятся в EEPROM и при старте попадают в хеш-таблицу в RAM
+#define KEYMAP_LEARN_MAX 12   // сколько кодов можно выучить
+#define KEYMAP_CACHE_SIZE 16  // слотов хеш-таблицы, степень двойки больше KEYMAP_LEARN_MAX
+
+void keymapInit();
+// найти кнопку по коду пульта, KEY_UNDEFINED если код неизвестен
+uint8_t keymapFind(uint32_t irCode);
+// запомнить код для кнопки, false если место закончилось
+bool keymapLearn(uint32_t irCode, uint8_t key);
+// забыть все выученные коды
+void keymapForget();
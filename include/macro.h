@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+
+// Макросы: одна кнопка пульта меняет сразу несколько полей состояния.
+// Макрос - строка байт во flash из пар (операция | поле STATE_*, значение),
+// в конце MACRO_END. Все поля меняются за один вызов, до stateTick(),
+// поэтому подписчики получают одно изменение, а не по изменению на поле.
+// Если вход остаётся тем же, в MCU уходит одна посылка регистров; смена
+// входа или mute идёт через плавный переход (ramp.h), по посылке на шаг.
+
+#define MACRO_SET 0x00    // поле = значение
+#define MACRO_ADD 0x80    // поле += значение (со знаком)
+#define MACRO_END 0xFF
+
+#define MACRO_COUNT 2
+
+// выполнить макрос n, false если такого нет
+bool macroRun(uint8_t n);
@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+
+// Асинхронная передача регистров в MCU усилителя по I2C.
+// Приложение задаёт желаемое содержимое регистров, а обмен ведётся в
+// прерывании TWI_vect. Теневая копия хранит то, что уже записано в MCU,
+// поэтому на шину уходят только изменившиеся регистры: соседние
+// изменения склеиваются в одну посылку с автоинкрементом субадреса.
+// Если шина занята, новое состояние просто заменяет ожидающее. Если MCU
+// не отвечает, после MCU_RETRIES неудач подряд состояние повторяется раз
+// в MCU_SLOW_RETRY_MS, пока MCU не ответит или не придёт новое; такие
+// повторы не считаются занятостью (mcuBusy()) и не мешают сну.
+
+#define MCU_ADR 0x41          // адрес MCU I2C
+#define MCU_REGS 5            // L, R, вход, режим, EQ
+#define MCU_REG_VOL_L 0
+#define MCU_REG_VOL_R 1
+#define MCU_REG_INPUT 2
+#define MCU_REG_MODE  3
+#define MCU_REG_EQ    4
+#define MCU_INPUT_MUTE B11100000 // регистр входа: все входы отключены
+#define MCU_MERGE_GAP 2       // чистые регистры между грязными, которые дешевле переписать, чем начать новую посылку
+#define MCU_I2C_HZ 100000UL
+#define MCU_TIMEOUT_MS 10     // таймаут транзакции, после него восстанавливаем шину
+#define MCU_RETRIES 3         // неудач подряд, после которых повторы становятся редкими
+#define MCU_SLOW_RETRY_MS 500 // период редких повторов
+
+typedef struct {
+  uint16_t done;      // успешно завершённые транзакции
+  uint16_t errors;    // NACK, потеря арбитража, ошибка шины
+  uint16_t timeouts;  // зависания шины, после которых было восстановление
+  uint16_t merged;    // состояния, заменённые более новыми до отправки
+  uint16_t gaveUp;    // переходы на редкие повторы после MCU_RETRIES неудач подряд
+  uint32_t bytes;     // байт на шине, включая SLA+W и субадрес
+} mcuStatsStruct;
+
+void mcuInit();
+void mcuWrite(const byte *regs);
+void mcuTick();
+bool mcuBusy();
+mcuStatsStruct mcuGetStats();
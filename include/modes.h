@@ -0,0 +1,30 @@
+#pragma once
+#include <Arduino.h>
+
+// Режимы управления. Каждая строка таблицы в modes.cpp описывает один
+// параметр состояния: пределы, шаг, как его показать и какие кнопки пульта
+// его меняют. Энкодер перебирает строки кликом, поворот и кнопки пульта
+// обрабатываются одним общим кодом по номеру строки.
+
+#define MODE_COUNT 4      // строк в таблице, перебираются энкодером
+
+#define MODE_WRAP _BV(0)  // по кругу, один шаг за щелчок без ускорения
+#define MODE_ONCE _BV(1)  // кнопка пульта не повторяется при удержании
+
+typedef struct {
+  uint8_t field;          // STATE_*
+  int8_t min;
+  int8_t max;
+  uint8_t step;
+  uint8_t flags;
+  const char *names;      // во flash: по два символа на значение от min, NULL - число
+  uint8_t keyUp;          // KEY_*
+  uint8_t keyDown;
+} modeStruct;
+
+// поворот энкодера в режиме mode на delta щелчков
+void modeTurn(uint8_t mode, int delta);
+// кнопка пульта, repeat - повтор при удержании. false, если кнопка не из таблицы
+bool modeKey(uint8_t key, int steps, bool repeat);
+// показать поле состояния в формате его строки
+void modeShow(uint8_t field);
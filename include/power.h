@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+
+// Сон в режиме mute. Когда звук выключен и ничего не происходит, индикация
+// гасится и МК засыпает в power-save. Будят его изменения уровня на
+// выводах энкодера (A1..A3), приёмника ИК (2) и RX (0).
+// В power-save стоят все таймеры, поэтому первый пакет ИК после сна
+// теряется: пульт повторяет его, пока кнопка нажата.
+
+#define POWER_IDLE_MS 3000    // сколько бездействовать перед сном
+
+typedef struct {
+  uint16_t sleeps;            // сколько раз засыпали
+  uint16_t wakeups;           // пробуждения по изменению уровня
+} powerStatsStruct;
+
+void powerInit();
+// отметить действие пользователя, сон откладывается на POWER_IDLE_MS
+void powerActivity();
+// сколько прошло с последнего powerActivity()
+unsigned long powerIdleMs();
+// уснуть, если canSleep и бездействие дольше POWER_IDLE_MS
+void powerTick(bool canSleep);
+powerStatsStruct powerGetStats();
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include "timebase.h"
+
+// Профилировщик стадий loop(). Включается флагом сборки -D PROFILER,
+// без него макросы ничего не делают и не занимают RAM.
+// Время берётся из Timer1 (0.5 мкс на тик), для каждой стадии копятся
+// min/max и гистограмма по степеням двойки. По команде PROTO_PROF_DUMP
+// уходит кадр PROTO_PROF (см. protocol.h). Пока кадр отправляется,
+// замеры не копятся, после отправки статистика сбрасывается.
+//
+// данные кадра: PROF_STAGES, PROF_BUCKETS,
+//       для каждой стадии min, max, hist[PROF_BUCKETS] (uint16_t LE)
+
+#define PROF_ENCODER 0
+#define PROF_IR      1
+#define PROF_SYNC    2
+#define PROF_DISPLAY 3
+#define PROF_LOOP    4
+#define PROF_STAGES  5
+
+#define PROF_BUCKETS 10  // корзина 0: < 8 мкс, дальше каждая вдвое шире, последняя - всё остальное
+
+#ifdef PROFILER
+void profRecord(uint8_t stage, uint16_t ticks);
+void profTick();
+// начать отправку кадра статистики
+void profDump();
+bool profBusy();
+
+#define PROF_BEGIN() uint16_t profT0 = timebaseNow(), profT = profT0
+#define PROF_MARK(stage) do { uint16_t n = timebaseNow(); profRecord(stage, n - profT); profT = n; } while (0)
+#define PROF_END() profRecord(PROF_LOOP, timebaseNow() - profT0)
+#define PROF_TICK() profTick()
+#define PROF_BUSY() profBusy()
+#else
+#define PROF_BEGIN()
+#define PROF_MARK(stage)
+#define PROF_END()
+#define PROF_TICK()
+#define PROF_BUSY() false
+#endif
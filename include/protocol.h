@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+
+// Двоичный протокол управления по Serial.
+// Кадр: 0xA5, длина (команда + данные), команда, данные, сумма всех
+// предыдущих байт по модулю 256. Приём разбирается по байту из буфера
+// UART без ожидания, ответы отправляются, только если для них есть место.
+
+#define PROTO_BAUD 115200
+#define PROTO_START 0xA5
+#define PROTO_MAX_DATA 12
+#define PROTO_MAX_REPLY 30     // данных в самом длинном ответе (PROTO_STATS)
+
+// команды хоста
+#define PROTO_GET_STATE 0x01  // -> PROTO_STATE
+#define PROTO_SET_STATE 0x02  // маска полей, громкость, бас, ВЧ, вход, mute -> PROTO_STATE
+#define PROTO_GET_STATS 0x03  // -> PROTO_STATS
+#define PROTO_PROF_DUMP 0x04  // -> PROTO_PROF (сборка с -D PROFILER)
+
+// ответы устройства
+#define PROTO_STATE 0x81      // громкость, бас, ВЧ, вход, mute
+#define PROTO_STATS 0x83      // счётчики I2C и протокола, uint16_t LE
+#define PROTO_PROF  0x84
+#define PROTO_EVENT 0x85      // запись teleRecord, см. telemetry.h
+#define PROTO_NAK   0xFF      // код отвергнутой команды
+
+// биты маски PROTO_SET_STATE
+#define PROTO_F_VOLUME _BV(0)
+#define PROTO_F_BASS   _BV(1)
+#define PROTO_F_TREBLE _BV(2)
+#define PROTO_F_INPUT  _BV(3)
+#define PROTO_F_MUTE   _BV(4)
+
+typedef void (*protoHandler)(uint8_t cmd, const byte *data, uint8_t len);
+
+typedef struct {
+  uint16_t frames;    // принятые целые кадры
+  uint16_t badFrames; // ошибка суммы или длины
+  uint16_t txDropped; // ответы, для которых не нашлось места в буфере UART
+} protoStatsStruct;
+
+void protoBegin(protoHandler handler);
+// разобрать то, что лежит в буфере приёма, пока есть место для ответов
+void protoTick();
+// отправить кадр целиком или ничего, false если нет места
+bool protoSend(uint8_t cmd, const byte *data, uint8_t len);
+// хватит ли места в буфере UART для кадра с len байтами данных
+// (пока уходит кадр профилировщика, места нет)
+bool protoRoom(uint8_t len);
+protoStatsStruct protoGetStats();
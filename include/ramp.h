@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+#include "mcu.h"
+#include "timebase.h"
+
+// Плавное переключение входа и mute без щелчков.
+// Если меняется регистр входа, громкость сначала по шагам кривой
+// (volcurve.h) уводится до шага 1, затем переключается вход, и громкость
+// так же возвращается. Если звука нет до или после переключения
+// (громкость 0 или MCU_INPUT_MUTE), соответствующая половина пропускается.
+// Шаги идут из прерывания TIMER1_COMPB, каждый шаг - одна запись в MCU.
+// Остальные изменения (громкость с энкодера, EQ) пишутся сразу.
+
+#define RAMP_STEP_US 2000   // период шага, мкс
+#define RAMP_STEP_TICKS TIMEBASE_US(RAMP_STEP_US)
+
+// передать желаемые регистры MCU и шаг громкости, по которому построены
+// регистры громкости; первый вызов пишет их без плавности
+void rampWrite(const byte *regs, int volume);
+bool rampActive();
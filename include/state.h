@@ -0,0 +1,61 @@
+#pragma once
+#include <Arduino.h>
+
+// Состояние усилителя. Менять его можно только через stateSet*(): сеттер
+// сравнивает значение и помечает изменившееся поле. stateTick() раздаёт
+// накопленные изменения подписчикам (MCU, индикация, EEPROM, телеметрия),
+// каждому только по полям из его маски. Если ничего не менялось,
+// stateTick() сразу возвращается.
+
+// номера полей, порядок как в PROTO_F_*
+#define STATE_VOLUME 0
+#define STATE_BASS   1
+#define STATE_TREBLE 2
+#define STATE_INPUT  3
+#define STATE_MUTE   4
+#define STATE_FIELDS 5
+
+#define STATE_F_VOLUME _BV(STATE_VOLUME)
+#define STATE_F_BASS   _BV(STATE_BASS)
+#define STATE_F_TREBLE _BV(STATE_TREBLE)
+#define STATE_F_INPUT  _BV(STATE_INPUT)
+#define STATE_F_MUTE   _BV(STATE_MUTE)
+#define STATE_F_ALL    (_BV(STATE_FIELDS) - 1)
+
+#define STATE_TONE_MAX 7        // бас и ВЧ от -7 до 7
+#define STATE_SUBSCRIBERS 4
+#define STATE_PACKED_LEN 4      // громкость, бас, ВЧ, вход | mute << 1
+#define STATE_F_PACKED STATE_F_ALL // поля, которые statePack() кладёт в эти байты
+
+enum INPUTS { AUX, PC};
+
+typedef struct {
+  bool isMute = true;
+  INPUTS inputCh = AUX;
+  int bass = 0;
+  int treble = 0;
+  int volume = 20;
+} stateStruct;
+
+// changed - изменившиеся поля из маски подписчика
+typedef void (*stateHandler)(uint8_t changed, const stateStruct &s);
+
+const stateStruct &stateGet();
+// значения вне диапазона ограничиваются
+void stateSetVolume(int volume);
+void stateSetBass(int bass);
+void stateSetTreble(int treble);
+void stateSetInput(INPUTS input);
+void stateSetMute(bool mute);
+// заменить состояние целиком, помечаются только отличающиеся поля
+void stateSet(const stateStruct &s);
+// доступ к полю по номеру STATE_*, вход и mute как 0/1
+int stateGetField(uint8_t field);
+void stateSetField(uint8_t field, int value);
+
+bool stateSubscribe(uint8_t mask, stateHandler handler);
+// разослать изменения, вызывать из loop()
+void stateTick();
+
+void statePack(const stateStruct &s, byte *data);
+void stateUnpack(const byte *data, stateStruct *s);
@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+
+// Сохранение состояния в EEPROM по кольцу записей (выравнивание износа).
+// Запись откладывается, пока состояние меняется, и идёт в фоне по одному
+// байту из прерывания EE_READY, loop() на ней не ждёт.
+
+#define STORAGE_DATA_LEN 4      // полезных байт в записи
+#define STORAGE_SLOTS 32        // записей в кольце
+#define STORAGE_DELAY_MS 5000   // сколько состояние должно не меняться до записи
+
+// прочитать последнюю целую запись, false если её нет
+bool storageLoad(byte *data);
+// новое состояние, запишется после STORAGE_DELAY_MS без изменений
+void storageSet(const byte *data);
+// вызывать из loop()
+void storageTick();
+// дождаться окончания фоновой записи (перед своими обращениями к EEPROM)
+void storageWait();
+bool storageBusy();
+// есть состояние, которое ещё ждёт записи (во сне millis() стоит, и оно не запишется)
+bool storagePending();
@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+
+// События для хоста. Записи фиксированного размера копятся в кольце и
+// уходят кадрами PROTO_EVENT, только когда в буфере UART есть место.
+// Если кольцо заполнено, новое событие отбрасывается и считается.
+
+#ifndef TELE_RING
+#define TELE_RING 8               // записей в кольце, степень двойки
+#endif
+
+#define TELE_UNKNOWN_CODE 1       // код пульта не найден в keymap
+#define TELE_STATE 2              // состояние изменилось: protocol - маска STATE_F_*, code - statePack()
+
+typedef struct {
+  uint8_t type;
+  int8_t protocol;                // decode_type_t из IRremote
+  uint32_t code;
+  uint32_t ms;                    // millis() на момент события
+} teleRecord;
+
+void telemetryPush(uint8_t type, int8_t protocol, uint32_t code);
+// отправить сколько влезет в буфер UART
+void telemetryTick();
+// всё отправлено
+bool telemetryIdle();
+uint16_t telemetryDropped();
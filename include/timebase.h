@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+#include <util/atomic.h>
+
+// Общая шкала времени на Timer1: свободный счёт с делителем 8 (0.5 мкс на тик).
+// Каналы сравнения раздаются модулям: A - индикация, B - плавная громкость.
+// Каждый модуль сам сдвигает свой OCR1x от текущего значения.
+
+#define TIMEBASE_HZ 2000000UL
+#define TIMEBASE_US(us) ((us) * (TIMEBASE_HZ / 1000000UL))
+
+void timebaseInit();
+
+// текущее значение счётчика. Чтение атомарное: прерывания, пишущие OCR1x,
+// портят общий TEMP регистр 16-битного доступа
+static inline uint16_t timebaseNow() {
+  uint16_t t;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    t = TCNT1;
+  }
+  return t;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+// Кривые громкости. Таблица кодов аттенюатора для шагов 0..MAX_VOLUME
+// строится при компиляции и лежит во flash, в прошивке нет float.
+// Кривая выбирается флагом сборки, например -D VOL_CURVE=VOL_CURVE_ODS
+#define VOL_CURVE_LINEAR 0  // 96 - 1.6 * v, как было раньше
+#define VOL_CURVE_ODS    1  // логарифмическая кривая из vol.ods
+#define VOL_CURVE_CUSTOM 2  // свои точки: -D VOL_CURVE_POINTS=96,48,24,0
+
+#ifndef VOL_CURVE
+#define VOL_CURVE VOL_CURVE_LINEAR
+#endif
+
+#define MAX_VOLUME 60
+#define VOL_ATT_MAX 96   // код аттенюатора на шаге 0 для линейной кривой
+#define VOL_ATT_MUTE 255 // код для громкости 0
+
+// код аттенюатора для шага громкости 0..MAX_VOLUME
+byte volToReg(int volume);
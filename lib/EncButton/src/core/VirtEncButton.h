@@ -9,6 +9,14 @@
 #define EB_FAST_T (EB_FAST_TIME)
 #endif
 
+// EB_FIFO_SIZE - очередь поворотов из прерывания на указанное число событий
+// (степень двойки) вместо буфера на 5 событий
+#ifdef EB_FIFO_SIZE
+#if (EB_FIFO_SIZE & (EB_FIFO_SIZE - 1)) || EB_FIFO_SIZE > 128
+#error "EB_FIFO_SIZE must be a power of two up to 128"
+#endif
+#endif
+
 // базовый клас энкодера с кнопкой
 class VirtEncButton : public VirtButton, public VirtEncoder {
    public:
@@ -20,6 +28,13 @@ class VirtEncButton : public VirtButton, public VirtEncoder {
 #endif
     }
 
+    // установить ускорение: при интервале между щелчками меньше time мс шаг
+    // линейно растёт от 1 до maxStep. maxStep 1 - без ускорения (умолч.)
+    void setEncAccel(const uint8_t time, const uint8_t maxStep) {
+        acc_t = time;
+        acc_max = maxStep ? maxStep : 1;
+    }
+
     // сбросить флаги энкодера и кнопки
     void clear() {
         VirtButton::clear();
@@ -37,6 +52,14 @@ class VirtEncButton : public VirtButton, public VirtEncoder {
         return ef.read(EB_FAST);
     }
 
+    // поворот с учётом ускорения: число шагов со знаком направления, 0 без поворота [событие]
+    int8_t delta() {
+        if (!turn()) return 0;
+        uint8_t step = 1;
+        if (acc_max > 1 && dt < acc_t) step += (uint16_t)(acc_t - dt) * (acc_max - 1) / acc_t;
+        return ef.read(EB_DIR) ? step : -step;
+    }
+
     // поворот направо [событие]
     bool right() {
         return ef.read(EB_DIR) && turn() && !bf.read(EB_EHLD);
@@ -47,6 +70,13 @@ class VirtEncButton : public VirtButton, public VirtEncoder {
         return !ef.read(EB_DIR) && turn() && !bf.read(EB_EHLD);
     }
 
+#ifdef EB_FIFO_SIZE
+    // сколько поворотов потеряно из-за переполнения очереди
+    uint8_t lostTurns() {
+        return flost;
+    }
+
+#endif
     // нажатый поворот направо [событие]
     bool rightH() {
         return ef.read(EB_DIR) && turnH();
@@ -79,7 +109,19 @@ class VirtEncButton : public VirtButton, public VirtEncoder {
     int8_t tickISR(int8_t state) {
         state = VirtEncoder::pollEnc(state);
         if (state) {
-#ifdef EB_NO_BUFFER
+#if defined(EB_FIFO_SIZE)
+            // очередь без блокировок: fhead пишет только прерывание, ftail - только tick
+            uint8_t h = fhead;
+            if ((uint8_t)(h - ftail) >= EB_FIFO_SIZE) {
+                if (flost != 255) flost++;
+            } else {
+                uint16_t ms = EB_uptime();
+                uint16_t d = ms - ftmr_isr;
+                ftmr_isr = ms;
+                fifo[h & (EB_FIFO_SIZE - 1)] = (d > 127 ? 127 : d) | (state > 0 ? 0x80 : 0);
+                fhead = h + 1;
+            }
+#elif defined(EB_NO_BUFFER)
             ef.set(EB_ISR_F);
             ef.write(EB_DIR, state > 0);
             ef.write(EB_FAST, checkFast());
@@ -130,7 +172,17 @@ class VirtEncButton : public VirtButton, public VirtEncoder {
         btn = VirtButton::tickRaw(btn);
 
         bool encf = 0;
-#ifdef EB_NO_BUFFER
+#if defined(EB_FIFO_SIZE)
+        if (fhead != ftail) {
+            uint8_t e = fifo[ftail & (EB_FIFO_SIZE - 1)];
+            ftail++;
+            dt = e & 0x7f;
+            ef.write(EB_DIR, e & 0x80);
+            ef.write(EB_FAST, dt < EB_FAST_T);
+            tmr = EB_uptime();  // таймаут отсчитывается от поворота, как в checkFast()
+            encf = 1;
+        }
+#elif defined(EB_NO_BUFFER)
         if (ef.read(EB_ISR_F)) {
             ef.clear(EB_ISR_F);
             encf = 1;
@@ -168,16 +220,26 @@ class VirtEncButton : public VirtButton, public VirtEncoder {
     uint8_t EB_FAST_T = 30;
 #endif
 
-#ifndef EB_NO_BUFFER
+#if defined(EB_FIFO_SIZE)
+    volatile uint8_t fifo[EB_FIFO_SIZE];
+    volatile uint8_t fhead = 0;
+    volatile uint8_t ftail = 0;
+    volatile uint8_t flost = 0;
+    uint16_t ftmr_isr = 0;
+#elif !defined(EB_NO_BUFFER)
     uint16_t ebuffer = 0;
 #endif
 
    private:
+    uint8_t dt = 255;     // интервал между последними щелчками, мс (до 255)
+    uint8_t acc_t = 0;
+    uint8_t acc_max = 1;
+
     bool checkFast() {
         uint16_t ms = EB_uptime();
-        bool f = 0;
-        if (ms - tmr < EB_FAST_T) f = 1;
+        uint16_t d = ms - tmr;
+        dt = d > 255 ? 255 : d;
         tmr = ms;
-        return f;
+        return d < EB_FAST_T;
     }
 };
\ No newline at end of file
@@ -115,16 +115,16 @@ int MATCH_SPACE(int measured_ticks, int desired_us) {
 
 //+=============================================================================
 // Interrupt Service Routine - Fires every 50uS
-// TIMER2 interrupt code to collect raw data.
-// Widths of alternating SPACE, MARK are recorded in rawbuf.
-// Recorded in ticks of 50uS [microseconds, 0.000050 seconds]
-// 'rawlen' counts the number of entries recorded so far.
-// First entry is the SPACE between transmissions.
-// As soon as a the first [SPACE] entry gets long:
-//   Ready is set; State switches to IDLE; Timing of SPACE continues.
-// As soon as first MARK arrives:
-//   Gap width is recorded; Ready is cleared; New logging starts
+// TIMER2 interrupt code to collect raw data, see irRecordTick().
+// With IR_USER_ISR the sketch defines this ISR itself and calls
+// IRrecvT<pin>::tickISR(), which reads the pin with a compile time port/bit.
 //
+#if defined(IR_EDGE_CAPTURE)
+ISR (INT0_vect) {
+    // INT0 is PD2 (pin 2)
+    irRecordEdge((PIND & _BV(PD2)) ? SPACE : MARK);
+}
+#elif !defined(IR_USER_ISR)
 ISR (TIMER_INTR_NAME) {
     TIMER_RESET_INTR_PENDING; // reset timer interrupt flag if required (currently only for Teensy and ATmega4809)
 
@@ -132,57 +132,7 @@ ISR (TIMER_INTR_NAME) {
     // digitalRead() is very slow. Optimisation is possible, but makes the code unportable
     uint8_t irdata = (uint8_t) digitalRead(irparams.recvpin);
 
-    irparams.timer++;  // One more 50uS tick
-    if (irparams.rawlen >= RAW_BUFFER_LENGTH) {
-        // Flag up a read overflow; Stop the State Machine
-        irparams.overflow = true;
-        irparams.rcvstate = IR_REC_STATE_STOP;
-    }
-
-    /*
-     * Due to a ESP32 compiler bug https://github.com/espressif/esp-idf/issues/1552 no switch statements are possible for ESP32
-     * So we change the code to if / else if
-     */
-//    switch (irparams.rcvstate) {
-    //......................................................................
-    if (irparams.rcvstate == IR_REC_STATE_IDLE) { // In the middle of a gap
-        if (irdata == MARK) {
-            if (irparams.timer < GAP_TICKS) {  // Not big enough to be a gap.
-                irparams.timer = 0;
-            } else {
-                // Gap just ended; Record gap duration; Start recording transmission
-                // Initialize all state machine variables
-                irparams.overflow = false;
-                irparams.rawlen = 0;
-                irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-                irparams.timer = 0;
-                irparams.rcvstate = IR_REC_STATE_MARK;
-            }
-        }
-    } else if (irparams.rcvstate == IR_REC_STATE_MARK) {  // Timing Mark
-        if (irdata == SPACE) {   // Mark ended; Record time
-            irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-            irparams.timer = 0;
-            irparams.rcvstate = IR_REC_STATE_SPACE;
-        }
-    } else if (irparams.rcvstate == IR_REC_STATE_SPACE) {  // Timing Space
-        if (irdata == MARK) {  // Space just ended; Record time
-            irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-            irparams.timer = 0;
-            irparams.rcvstate = IR_REC_STATE_MARK;
-
-        } else if (irparams.timer > GAP_TICKS) {  // Space
-            // A long Space, indicates gap between codes
-            // Flag the current code as ready for processing
-            // Switch to STOP
-            // Don't reset timer; keep counting Space width
-            irparams.rcvstate = IR_REC_STATE_STOP;
-        }
-    } else if (irparams.rcvstate == IR_REC_STATE_STOP) {  // Waiting; Measuring Gap
-        if (irdata == MARK) {
-            irparams.timer = 0;  // Reset gap timer
-        }
-    }
+    irRecordTick(irdata);
 
 #ifdef BLINKLED
     // If requested, flash LED while receiving IR data
@@ -203,3 +153,4 @@ ISR (TIMER_INTR_NAME) {
     }
 #endif // BLINKLED
 }
+#endif // IR_EDGE_CAPTURE
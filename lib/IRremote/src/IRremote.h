@@ -104,6 +104,29 @@
 
 #define DECODE_HASH          1 // special decoder for all protocols
 
+/*
+ * The ISR discards frames longer than RAW_BUFFER_LENGTH (counted by getOverflows()),
+ * so a decoder whose frames never fit into rawbuf can not match anything.
+ * Such decoders are disabled here instead of silently costing flash and decode time.
+ * Lengths include the leading gap entry.
+ */
+#if DECODE_AIWA_RC_T501 && RAW_BUFFER_LENGTH < 2 * (26 + 15 + 1) + 4 // pre bits, data, post bit
+#undef DECODE_AIWA_RC_T501
+#define DECODE_AIWA_RC_T501  0
+#endif
+#if DECODE_MAGIQUEST && RAW_BUFFER_LENGTH < 2 * 50                  // 50 bits, no header
+#undef DECODE_MAGIQUEST
+#define DECODE_MAGIQUEST     0
+#endif
+#if DECODE_PANASONIC && RAW_BUFFER_LENGTH < 1 + 2 + 2 * 48 + 1      // header, 48 bits, stop
+#undef DECODE_PANASONIC
+#define DECODE_PANASONIC     0
+#endif
+#if DECODE_WHYNTER && RAW_BUFFER_LENGTH < 2 * 32 + 6                // start bit, header, 32 bits, stop
+#undef DECODE_WHYNTER
+#define DECODE_WHYNTER       0
+#endif
+
 /**
  * An enum consisting of all supported formats.
  * You do NOT need to remove entries from this list when disabling protocols!
@@ -181,10 +204,10 @@ struct decode_results {
     unsigned int magnitude;     ///< Used by MagiQuest [16-bits]
     bool isRepeat;              ///< True if repeat of value is detected
 
-    // next 3 values are copies of irparams values
-    unsigned int *rawbuf;       ///< Raw intervals in 50uS ticks
+    // next 3 values describe the oldest frame in the irparams ring
+    rawbuf_t rawbuf;            ///< Raw intervals in 50uS ticks, index it as an array
     unsigned int rawlen;        ///< Number of records in rawbuf
-    bool overflow;               ///< true if IR raw code too long
+    bool overflow;               ///< always false, overflowed frames are counted in getOverflows()
 };
 
 /**
@@ -249,10 +272,27 @@ public:
     bool available();
 
     /**
-     * Called to re-enable IR reception.
+     * Release the frame returned by decode() or available(), the next one becomes current.
      */
     void resume();
 
+    /**
+     * Frames discarded because they were longer than RAW_BUFFER_LENGTH.
+     */
+    unsigned int getOverflows();
+
+    /**
+     * Frames discarded because all IR_FRAME_SLOTS were waiting for resume().
+     */
+    unsigned int getDropped();
+
+#if defined(IR_DECODE_STATS)
+    /**
+     * Protocol decoders called by decode() so far, for benchmarks of the signature table.
+     */
+    unsigned long decoderCalls;
+#endif
+
     const char* getProtocolString();
     void printResultShort(Print * aSerial);
 
@@ -270,6 +310,13 @@ public:
     decode_results results; // the instance for decoding
 
 private:
+    /**
+     * Call the decoders whose header and length signature fits results.
+     * @param aNewApi false to skip the protocols unknown to the deprecated decode(decode_results*).
+     */
+    bool decodeBySignature(bool aNewApi);
+    bool decodeWith(uint8_t aDecoder);
+
 #if DECODE_HASH
     bool decodeHash();
     bool decodeHash(decode_results *aResults);
@@ -378,6 +425,37 @@ private:
 #endif
 };
 
+#if defined(IR_USER_ISR)
+#include <GyverIO.h>
+/**
+ * Receiver with the pin fixed at compile time.
+ * Build with IR_USER_ISR, the library then does not define the timer ISR and
+ * the sketch has to forward it:
+ *   IRrecvT<2> IrReceiver;
+ *   ISR(TIMER_INTR_NAME) { IrReceiver.tickISR(); }
+ * gio::read() with a constant pin compiles to a single port bit test instead
+ * of the table lookups of digitalRead(). Blinking is not supported.
+ */
+template <uint8_t PIN>
+class IRrecvT : public IRrecv {
+#if defined(IR_EDGE_CAPTURE)
+    static_assert(PIN == 2, "IR_EDGE_CAPTURE records edges with INT0, the receiver must be on pin 2");
+#endif
+public:
+    IRrecvT() :
+            IRrecv(PIN) {
+    }
+
+    /**
+     * Call from ISR(TIMER_INTR_NAME).
+     */
+    void tickISR() {
+        TIMER_RESET_INTR_PENDING;
+        irRecordTick(gio::read(PIN));
+    }
+};
+#endif
+
 /****************************************************
  *                     SENDING
  ****************************************************/
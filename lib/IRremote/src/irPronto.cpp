@@ -132,9 +132,9 @@ static void dumpDuration(Stream& stream, uint16_t duration, uint16_t timebase) {
     dumpNumber(stream, (duration * MICROS_PER_TICK + timebase / 2) / timebase);
 }
 
-static void dumpSequence(Stream& stream, const volatile unsigned int *data, size_t length, uint16_t timebase) {
-    for (unsigned int i = 0; i < length; i++)
-        dumpDuration(stream, data[i], timebase);
+static void dumpSequence(Stream& stream, const decode_results &results, uint16_t timebase) {
+    for (unsigned int i = RESULT_JUNK_COUNT; i < results.rawlen; i++)
+        dumpDuration(stream, results.rawbuf[i], timebase);
 
     dumpDuration(stream, _GAP, timebase);
 }
@@ -145,5 +145,5 @@ void IRrecv::dumpPronto(Stream& stream, unsigned int frequency) {
     dumpNumber(stream, (results.rawlen + 1) / 2);
     dumpNumber(stream, 0);
     unsigned int timebase = toTimebase(frequency);
-    dumpSequence(stream, results.rawbuf + RESULT_JUNK_COUNT, results.rawlen - RESULT_JUNK_COUNT, timebase);
+    dumpSequence(stream, results, timebase);
 }
@@ -1,161 +1,292 @@
 #include "IRremote.h"
 
 //+=============================================================================
-// Decodes the received IR message
-// Returns 0 if no data ready, 1 if data ready.
-// Results of decoding are stored in results
+// Point results at the oldest complete frame in the ring
+// Returns false if the ISR has not committed any frame yet
 //
-bool IRrecv::decode() {
-    if (irparams.rcvstate != IR_REC_STATE_STOP) {
+static bool nextFrame(decode_results &results) {
+#if defined(IR_EDGE_CAPTURE)
+    irCheckGap();
+#endif
+    if (irparams.head == irparams.tail) {
         return false;
     }
+    struct irframe_struct *frame = &irparams.frames[irparams.tail % IR_FRAME_SLOTS];
+#if defined(IR_RAW_COMPACT)
+    results.rawbuf.raw = frame->rawbuf;
+    results.rawbuf.longs = frame->longs;
+#else
+    results.rawbuf = frame->rawbuf;
+#endif
+    results.rawlen = frame->rawlen;
+    results.overflow = false; // overflowed frames never reach the ring
+    return true;
+}
 
-    /*
-     * First copy 3 values from irparams to internal results structure
-     */
-    results.rawbuf = irparams.rawbuf;
-    results.rawlen = irparams.rawlen;
-    results.overflow = irparams.overflow;
+//+=============================================================================
+// Decoder dispatch
+// The first mark, the first space and rawlen of a frame are classified once
+// and only the decoders whose signature fits are called, in the order of the
+// former decode() chain, so the first decoder to accept a frame is the same.
+// A signature must admit every frame its decoder can accept: bounds use the
+// tolerances of MATCH_MARK() / MATCH_SPACE(), decoders that do not check a
+// value get SIG_ANY. The gap based repeat checks of Sony and Sanyo look for a
+// gap below GAP_TICKS, which the ISR never records, so they need no row.
+// IR_DECODE_CHAIN skips the signatures and calls every decoder in turn like
+// the former chain; tests and benchmarks use it as the reference.
+// IR_DECODE_STATS counts the decoders called in IRrecv::decoderCalls.
+//
+#define DECODER_NEC_STANDARD    1
+#define DECODER_NEC             2
+#define DECODER_SHARP           3
+#define DECODER_SHARP_ALT       4
+#define DECODER_SONY            5
+#define DECODER_SANYO           6
+#define DECODER_MITSUBISHI      7
+#define DECODER_RC5             8
+#define DECODER_RC6             9
+#define DECODER_PANASONIC      10
+#define DECODER_LG             11
+#define DECODER_JVC            12
+#define DECODER_SAMSUNG        13
+#define DECODER_WHYNTER        14
+#define DECODER_AIWA_RC_T501   15
+#define DECODER_DENON          16
+#define DECODER_LEGO_PF        17
+#define DECODER_MAGIQUEST      18
+#define DECODER_HASH           19
+#define DECODER_NEW_API      0x80  ///< not tried by the deprecated decode(decode_results*)
+
+// Signature bounds in ticks
+#define SIG_MARK(lowUs, highUs)   TICKS_LOW((lowUs) + MARK_EXCESS_MICROS), TICKS_HIGH((highUs) + MARK_EXCESS_MICROS)
+#define SIG_SPACE(lowUs, highUs)  TICKS_LOW((lowUs) - MARK_EXCESS_MICROS), TICKS_HIGH((highUs) - MARK_EXCESS_MICROS)
+#define SIG_ANY                   0, 0xFF
+
+struct decoder_signature {
+    uint8_t decoder;            ///< DECODER_*
+    uint8_t minLength;          ///< rawlen, longer frames are classified as 0xFF
+    uint8_t maxLength;
+    uint8_t markLow;            ///< rawbuf[1]
+    uint8_t markHigh;
+    uint8_t spaceLow;           ///< rawbuf[2]
+    uint8_t spaceHigh;
+};
+
+static const struct decoder_signature decoderSignatures[] PROGMEM = {
+#if DECODE_NEC_STANDARD
+    { DECODER_NEC_STANDARD | DECODER_NEW_API, 4, 0xFF, SIG_MARK(9000, 9000), SIG_SPACE(2250, 4500) },
+#endif
+#if DECODE_NEC
+    { DECODER_NEC, 4, 0xFF, SIG_MARK(9000, 9000), SIG_SPACE(2250, 4500) },
+#endif
+#if DECODE_SHARP
+    { DECODER_SHARP, 32, 96, SIG_MARK(150, 150), SIG_SPACE(795, 1805) },
+#endif
+#if DECODE_SHARP_ALT
+    { DECODER_SHARP_ALT, 32, 0xFF, SIG_ANY, SIG_ANY },
+#endif
+#if DECODE_SONY
+    { DECODER_SONY, 26, 0xFF, SIG_MARK(2400, 2400), SIG_ANY },
+#endif
+#if DECODE_SANYO
+    { DECODER_SANYO, 26, 0xFF, SIG_MARK(3500, 3500), SIG_MARK(3500, 3500) },
+#endif
+#if DECODE_MITSUBISHI
+    { DECODER_MITSUBISHI, 34, 0xFF, SIG_MARK(350, 350), SIG_MARK(750, 1950) },
+#endif
+#if DECODE_RC5
+    // one to three T1 of the start bit
+    { DECODER_RC5, 13, 0xFF, SIG_MARK(889, 3 * 889), SIG_SPACE(889, 3 * 889) },
+#endif
+#if DECODE_RC6
+    { DECODER_RC6, 1, 0xFF, SIG_MARK(2666, 2666), SIG_SPACE(889, 889) },
+#endif
+#if DECODE_PANASONIC
+    { DECODER_PANASONIC, 3, 0xFF, SIG_MARK(3502, 3502), SIG_MARK(1750, 1750) },
+#endif
+#if DECODE_LG
+    { DECODER_LG, 57, 0xFF, SIG_MARK(8400, 8400), SIG_SPACE(4200, 4200) },
+#endif
+#if DECODE_JVC
+    // repeat, then full frame
+    { DECODER_JVC, 34, 34, SIG_MARK(600, 600), SIG_ANY },
+    { DECODER_JVC, 33, 0xFF, SIG_MARK(8400, 8400), SIG_SPACE(4200, 4200) },
+#endif
+#if DECODE_SAMSUNG
+    { DECODER_SAMSUNG, 4, 0xFF, SIG_MARK(4500, 4500), SIG_SPACE(2250, 4500) },
+#endif
+#if DECODE_WHYNTER
+    { DECODER_WHYNTER, 70, 0xFF, SIG_MARK(750, 750), SIG_SPACE(750, 750) },
+#endif
+#if DECODE_AIWA_RC_T501
+    { DECODER_AIWA_RC_T501, 88, 0xFF, SIG_MARK(8800, 8800), SIG_SPACE(4500, 4500) },
+#endif
+#if DECODE_DENON
+    { DECODER_DENON, 32, 32, SIG_MARK(300, 300), SIG_SPACE(750, 750) },
+#endif
+#if DECODE_LEGO_PF
+    { DECODER_LEGO_PF | DECODER_NEW_API, 1, 0xFF, SIG_ANY, SIG_ANY },
+#endif
+#if DECODE_MAGIQUEST
+    { DECODER_MAGIQUEST | DECODER_NEW_API, 100, 0xFF, SIG_ANY, SIG_ANY },
+#endif
+#if DECODE_HASH
+    // decodeHash returns a hash on any input, it needs to be last in the list.
+    { DECODER_HASH, 6, 0xFF, SIG_ANY, SIG_ANY },
+#endif
+};
 
-    // reset optional values
-    results.address = 0;
-    results.isRepeat = false;
+static uint8_t classify(unsigned int ticks) {
+    return ticks > 0xFF ? 0xFF : ticks;
+}
 
-#if DECODE_NEC_STANDARD
-    DBG_PRINTLN("Attempting NEC_STANDARD decode");
-    if (decodeNECStandard()) {
-        return true;
-    }
+bool IRrecv::decodeBySignature(bool aNewApi) {
+    uint8_t length = classify(results.rawlen);
+    uint8_t mark = results.rawlen > 1 ? classify(results.rawbuf[1]) : 0;
+    uint8_t space = results.rawlen > 2 ? classify(results.rawbuf[2]) : 0;
+
+    for (uint8_t i = 0; i < sizeof(decoderSignatures) / sizeof(decoderSignatures[0]); i++) {
+        struct decoder_signature sig;
+        memcpy_P(&sig, &decoderSignatures[i], sizeof(sig));
+        if ((sig.decoder & DECODER_NEW_API) && !aNewApi) {
+            continue;
+        }
+#if defined(IR_DECODE_CHAIN)
+        (void) length, (void) mark, (void) space;
+#else
+        if (length < sig.minLength || length > sig.maxLength || mark < sig.markLow || mark > sig.markHigh
+                || space < sig.spaceLow || space > sig.spaceHigh) {
+            continue;
+        }
 #endif
+#if defined(IR_DECODE_STATS)
+        decoderCalls++;
+#endif
+        if (decodeWith(sig.decoder & ~DECODER_NEW_API)) {
+            return true;
+        }
+    }
+    return false;
+}
 
+bool IRrecv::decodeWith(uint8_t aDecoder) {
+    switch (aDecoder) {
+#if DECODE_NEC_STANDARD
+    case DECODER_NEC_STANDARD:
+        DBG_PRINTLN("Attempting NEC_STANDARD decode");
+        return decodeNECStandard();
+#endif
 #if DECODE_NEC
-    DBG_PRINTLN("Attempting NEC decode");
-    if (decodeNEC()) {
-        return true;
-    }
+    case DECODER_NEC:
+        DBG_PRINTLN("Attempting NEC decode");
+        return decodeNEC();
 #endif
-
 #if DECODE_SHARP
-    DBG_PRINTLN("Attempting Sharp decode");
-    if (decodeSharp()) {
-        return true;
-    }
+    case DECODER_SHARP:
+        DBG_PRINTLN("Attempting Sharp decode");
+        return decodeSharp();
 #endif
-
 #if DECODE_SHARP_ALT
-    DBG_PRINTLN("Attempting SharpAlt decode");
-    if (decodeSharpAlt()) {
-        return true;
-    }
+    case DECODER_SHARP_ALT:
+        DBG_PRINTLN("Attempting SharpAlt decode");
+        return decodeSharpAlt();
 #endif
-
 #if DECODE_SONY
-    DBG_PRINTLN("Attempting Sony decode");
-    if (decodeSony()) {
-        return true;
-    }
+    case DECODER_SONY:
+        DBG_PRINTLN("Attempting Sony decode");
+        return decodeSony();
 #endif
-
 #if DECODE_SANYO
-    DBG_PRINTLN("Attempting Sanyo decode");
-    if (decodeSanyo()) {
-        return true;
-    }
+    case DECODER_SANYO:
+        DBG_PRINTLN("Attempting Sanyo decode");
+        return decodeSanyo();
 #endif
-
 #if DECODE_MITSUBISHI
-    DBG_PRINTLN("Attempting Mitsubishi decode");
-    if (decodeMitsubishi()) {
-        return true;
-    }
+    case DECODER_MITSUBISHI:
+        DBG_PRINTLN("Attempting Mitsubishi decode");
+        return decodeMitsubishi();
 #endif
-
 #if DECODE_RC5
-    DBG_PRINTLN("Attempting RC5 decode");
-    if (decodeRC5()) {
-        return true;
-    }
+    case DECODER_RC5:
+        DBG_PRINTLN("Attempting RC5 decode");
+        return decodeRC5();
 #endif
-
 #if DECODE_RC6
-    DBG_PRINTLN("Attempting RC6 decode");
-    if (decodeRC6()) {
-        return true;
-    }
+    case DECODER_RC6:
+        DBG_PRINTLN("Attempting RC6 decode");
+        return decodeRC6();
 #endif
-
 #if DECODE_PANASONIC
-    DBG_PRINTLN("Attempting Panasonic decode");
-    if (decodePanasonic()) {
-        return true;
-    }
+    case DECODER_PANASONIC:
+        DBG_PRINTLN("Attempting Panasonic decode");
+        return decodePanasonic();
 #endif
-
 #if DECODE_LG
-    DBG_PRINTLN("Attempting LG decode");
-    if (decodeLG()) {
-        return true;
-    }
+    case DECODER_LG:
+        DBG_PRINTLN("Attempting LG decode");
+        return decodeLG();
 #endif
-
 #if DECODE_JVC
-    DBG_PRINTLN("Attempting JVC decode");
-    if (decodeJVC()) {
-        return true;
-    }
+    case DECODER_JVC:
+        DBG_PRINTLN("Attempting JVC decode");
+        return decodeJVC();
 #endif
-
 #if DECODE_SAMSUNG
-    DBG_PRINTLN("Attempting SAMSUNG decode");
-    if (decodeSAMSUNG()) {
-        return true;
-    }
+    case DECODER_SAMSUNG:
+        DBG_PRINTLN("Attempting SAMSUNG decode");
+        return decodeSAMSUNG();
 #endif
-
 #if DECODE_WHYNTER
-    DBG_PRINTLN("Attempting Whynter decode");
-    if (decodeWhynter()) {
-        return true;
-    }
+    case DECODER_WHYNTER:
+        DBG_PRINTLN("Attempting Whynter decode");
+        return decodeWhynter();
 #endif
-
 #if DECODE_AIWA_RC_T501
-    DBG_PRINTLN("Attempting Aiwa RC-T501 decode");
-    if (decodeAiwaRCT501()) {
-        return true;
-    }
+    case DECODER_AIWA_RC_T501:
+        DBG_PRINTLN("Attempting Aiwa RC-T501 decode");
+        return decodeAiwaRCT501();
 #endif
-
 #if DECODE_DENON
-    DBG_PRINTLN("Attempting Denon decode");
-    if (decodeDenon()) {
-        return true;
-    }
+    case DECODER_DENON:
+        DBG_PRINTLN("Attempting Denon decode");
+        return decodeDenon();
 #endif
-
 #if DECODE_LEGO_PF
-    DBG_PRINTLN("Attempting Lego Power Functions");
-    if (decodeLegoPowerFunctions()) {
-        return true;
-    }
+    case DECODER_LEGO_PF:
+        DBG_PRINTLN("Attempting Lego Power Functions");
+        return decodeLegoPowerFunctions();
 #endif
-
 #if DECODE_MAGIQUEST
-    DBG_PRINTLN("Attempting MagiQuest decode");
-    if (decodeMagiQuest()) {
-        return true;
-    }
+    case DECODER_MAGIQUEST:
+        DBG_PRINTLN("Attempting MagiQuest decode");
+        return decodeMagiQuest();
 #endif
-
 #if DECODE_HASH
-    DBG_PRINTLN("Hash decode");
-    // decodeHash returns a hash on any input.
-    // Thus, it needs to be last in the list.
-    // If you add any decodes, add them before this.
-    if (decodeHash()) {
+    case DECODER_HASH:
+        DBG_PRINTLN("Hash decode");
+        return decodeHash();
+#endif
+    }
+    return false;
+}
+
+//+=============================================================================
+// Decodes the received IR message
+// Returns 0 if no data ready, 1 if data ready.
+// Results of decoding are stored in results
+//
+bool IRrecv::decode() {
+    if (!nextFrame(results)) {
+        return false;
+    }
+
+    // reset optional values
+    results.address = 0;
+    results.isRepeat = false;
+
+    if (decodeBySignature(true)) {
         return true;
     }
-#endif
 
     // Throw away and start over
     resume();
@@ -178,7 +309,24 @@ IRrecv::IRrecv(int recvpin, int blinkpin) {
 //+=============================================================================
 // initialization
 //
-#ifdef USE_DEFAULT_ENABLE_IR_IN
+#if defined(IR_EDGE_CAPTURE)
+void IRrecv::enableIRIn() {
+    pinMode(irparams.recvpin, INPUT);
+    noInterrupts();
+    irparams.rcvstate = IR_REC_STATE_IDLE;
+    irparams.lastedge = micros();
+    // INT0 on any logical change
+    EICRA = (EICRA & ~(_BV(ISC01) | _BV(ISC00))) | _BV(ISC00);
+    EIFR = _BV(INTF0);
+    EIMSK |= _BV(INT0);
+    interrupts();
+}
+
+void IRrecv::disableIRIn() {
+    EIMSK &= ~_BV(INT0);
+}
+
+#elif defined(USE_DEFAULT_ENABLE_IR_IN)
 void IRrecv::enableIRIn() {
 // the interrupt Service Routine fires every 50 uS
     noInterrupts();
@@ -197,7 +345,6 @@ void IRrecv::enableIRIn() {
 
     // Initialize state machine state
     irparams.rcvstate = IR_REC_STATE_IDLE;
-    //    irparams.rawlen = 0; // not required
 
     // Set pin modes
     pinMode(irparams.recvpin, INPUT);
@@ -225,30 +372,37 @@ void IRrecv::blink13(int blinkflag) {
 // Return if receiving new IR signals
 //
 bool IRrecv::isIdle() {
-    return (irparams.rcvstate == IR_REC_STATE_IDLE || irparams.rcvstate == IR_REC_STATE_STOP) ? true : false;
+#if defined(IR_EDGE_CAPTURE)
+    irCheckGap();
+#endif
+    return irparams.rcvstate == IR_REC_STATE_IDLE;
 }
 
 bool IRrecv::available() {
-    if (irparams.rcvstate != IR_REC_STATE_STOP) {
-        return false;
-    }
-    results.rawbuf = irparams.rawbuf;
-    results.rawlen = irparams.rawlen;
-
-    results.overflow = irparams.overflow;
-    if (!results.overflow) {
-        return true;
-    }
-    resume(); //skip overflowed buffer
-    return false;
+    return nextFrame(results);
 }
 
 //+=============================================================================
-// Restart the ISR state machine
+// Release the current frame, the ISR keeps recording meanwhile
 //
 void IRrecv::resume() {
-    irparams.rcvstate = IR_REC_STATE_IDLE;
-//    irparams.rawlen = 0; // not required
+    if (irparams.head != irparams.tail) {
+        irparams.tail++;
+    }
+}
+
+unsigned int IRrecv::getOverflows() {
+    noInterrupts();
+    unsigned int n = irparams.overflows;
+    interrupts();
+    return n;
+}
+
+unsigned int IRrecv::getDropped() {
+    noInterrupts();
+    unsigned int n = irparams.dropped;
+    interrupts();
+    return n;
 }
 
 # if DECODE_HASH
@@ -497,142 +651,18 @@ void IRrecv::printResultShort(Print * aSerial) {
  * Contains no new (since 5/2020) protocols.
  */
 bool IRrecv::decode(decode_results *aResults) {
-    if (irparams.rcvstate != IR_REC_STATE_STOP) {
+    if (!nextFrame(results)) {
         return false;
     }
 
-    /*
-     * First copy 3 values from irparams to internal results structure
-     */
-    results.rawbuf = irparams.rawbuf;
-    results.rawlen = irparams.rawlen;
-    results.overflow = irparams.overflow;
-
     // reset optional values
     results.address = 0;
     results.isRepeat = false;
 
-#if DECODE_NEC
-    DBG_PRINTLN("Attempting NEC decode");
-    if (decodeNEC(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_SHARP
-    DBG_PRINTLN("Attempting Sharp decode");
-    if (decodeSharp(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_SHARP_ALT
-    DBG_PRINTLN("Attempting SharpAlt decode");
-    if (decodeSharpAlt(aResults)) {
+    if (decodeBySignature(false)) {
+        *aResults = results;
         return true;
     }
-#endif
-
-#if DECODE_SONY
-    DBG_PRINTLN("Attempting Sony decode");
-    if (decodeSony(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_SANYO
-    DBG_PRINTLN("Attempting Sanyo decode");
-    if (decodeSanyo(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_MITSUBISHI
-    DBG_PRINTLN("Attempting Mitsubishi decode");
-    if (decodeMitsubishi(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_RC5
-    DBG_PRINTLN("Attempting RC5 decode");
-    if (decodeRC5(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_RC6
-    DBG_PRINTLN("Attempting RC6 decode");
-    if (decodeRC6(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_PANASONIC
-    DBG_PRINTLN("Attempting Panasonic decode");
-    if (decodePanasonic(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_LG
-    DBG_PRINTLN("Attempting LG decode");
-    if (decodeLG(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_JVC
-    DBG_PRINTLN("Attempting JVC decode");
-    if (decodeJVC(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_SAMSUNG
-    DBG_PRINTLN("Attempting SAMSUNG decode");
-    if (decodeSAMSUNG(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_WHYNTER
-    DBG_PRINTLN("Attempting Whynter decode");
-    if (decodeWhynter(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_AIWA_RC_T501
-    DBG_PRINTLN("Attempting Aiwa RC-T501 decode");
-    if (decodeAiwaRCT501(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_DENON
-    DBG_PRINTLN("Attempting Denon decode");
-    if (decodeDenon(aResults)) {
-        return true;
-    }
-#endif
-
-#if DECODE_LEGO_PF
-    DBG_PRINTLN("Attempting Lego Power Functions");
-    if (decodeLegoPowerFunctions(aResults))  {
-        return true ;
-    }
-#endif
-
-#if defined(DECODE_HASH)
-    DBG_PRINTLN("Hash decode");
-    // decodeHash returns a hash on any input.
-    // Thus, it needs to be last in the list.
-    // If you add any decodes, add them before this.
-    if (decodeHash(aResults)) {
-        return true;
-    }
-#endif
 
     // Throw away and start over
     resume();
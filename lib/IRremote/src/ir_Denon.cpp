@@ -64,7 +64,7 @@ bool IRrecv::decodeDenon() {
     int offset = 1;  // Skip the gap reading
 
     // Check we have the right amount of data
-    if (irparams.rawlen != 1 + 2 + (2 * DENON_BITS) + 1) {
+    if (results.rawlen != 1 + 2 + (2 * DENON_BITS) + 1) {
         return false;
     }
 
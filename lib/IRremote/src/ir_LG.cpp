@@ -23,7 +23,7 @@ bool IRrecv::decodeLG() {
     int offset = 1; // Skip first space
 
     // Check we have the right amount of data
-    if (irparams.rawlen < (2 * LG_BITS) + 1)
+    if (results.rawlen < (2 * LG_BITS) + 1)
         return false;
 
     // Initial mark/space
@@ -91,7 +91,7 @@ bool IRrecv::decodeMagiQuest() {
     // Check we have enough data
     if (results.rawlen < 2 * MAGIQUEST_BITS) {
         DBG_PRINT("Not enough bits to be a MagiQuest packet (");
-        DBG_PRINT(irparams.rawlen);
+        DBG_PRINT(results.rawlen);
         DBG_PRINT(" < ");
         DBG_PRINT(MAGIQUEST_BITS*2);
         DBG_PRINTLN(")");
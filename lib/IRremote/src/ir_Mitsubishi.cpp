@@ -24,7 +24,7 @@
 //+=============================================================================
 #if DECODE_MITSUBISHI
 bool IRrecv::decodeMitsubishi() {
-    // Serial.print("?!? decoding Mitsubishi:");Serial.print(irparams.rawlen); Serial.print(" want "); Serial.println( 2 * MITSUBISHI_BITS + 2);
+    // Serial.print("?!? decoding Mitsubishi:");Serial.print(results.rawlen); Serial.print(" want "); Serial.println( 2 * MITSUBISHI_BITS + 2);
     long data = 0;
     if (results.rawlen < 2 * MITSUBISHI_BITS + 2)
         return false;
@@ -58,7 +58,7 @@ bool IRrecv::decodeMitsubishi() {
         return false;
     offset++;
 
-    while (offset + 1 < irparams.rawlen) {
+    while (offset + 1 < results.rawlen) {
         if (MATCH_MARK(results.rawbuf[offset], MITSUBISHI_ONE_MARK))
             data = (data << 1) | 1;
         else if (MATCH_MARK(results.rawbuf[offset], MITSUBISHI_ZERO_MARK))
@@ -29,19 +29,96 @@
 //------------------------------------------------------------------------------
 // Information for the Interrupt Service Routine
 //
+/*
+ * IR_EDGE_CAPTURE: instead of sampling the pin every 50 us from a timer ISR,
+ * timestamp every edge from the INT0 interrupt (receiver on pin 2) with
+ * micros(). No interrupts occur while the line is idle; the end of a frame
+ * is detected when decode(), available() or isIdle() is called.
+ * Edges are timed to 4 us, but durations are rounded to the same 50 us ticks
+ * before they go into rawbuf: with IR_RAW_COMPACT a finer unit would push
+ * header marks and spaces past one byte and into the escape slots, and even
+ * with 16-bit rawbuf the library is only exercised at MICROS_PER_TICK 50 (at
+ * 4 us NEC frames in test_ir_edge no longer decode). Rounding still removes
+ * the up to 50 us sampling error of the polling ISR.
+ */
+#if defined(IR_EDGE_CAPTURE) && !(defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) \
+        || defined(__AVR_ATmega328__) || defined(__AVR_ATmega328P__))
+#error "IR_EDGE_CAPTURE is implemented for INT0 of ATmega168/328 only"
+#endif
+
 #if ! defined(RAW_BUFFER_LENGTH)
 #define RAW_BUFFER_LENGTH  101  ///< Maximum length of raw duration buffer. Must be odd.
 #endif
 
+/*
+ * IR_FRAME_SLOTS: number of frames the ISR can hold for the application.
+ * A finished frame is committed to the ring and the ISR goes straight back
+ * to waiting for the next one; resume() releases the oldest slot. A frame
+ * arriving while all slots are taken is counted in irparams.dropped.
+ * Must be a power of two.
+ */
+#if ! defined(IR_FRAME_SLOTS)
+#define IR_FRAME_SLOTS  1
+#endif
+#if (IR_FRAME_SLOTS & (IR_FRAME_SLOTS - 1)) || IR_FRAME_SLOTS > 128
+#error "IR_FRAME_SLOTS must be a power of two up to 128"
+#endif
+
 // ISR State-Machine : Receiver States
 #define IR_REC_STATE_IDLE      0
 #define IR_REC_STATE_MARK      1
 #define IR_REC_STATE_SPACE     2
-#define IR_REC_STATE_STOP      3
+#define IR_REC_STATE_STOP      3    ///< not entered any more, frames are committed to the ring
+
+/*
+ * IR_RAW_COMPACT: store durations in one byte instead of two.
+ * Spaces inside a frame are shorter than GAP_TICKS and marks are shorter
+ * still, so only the gap before the frame normally needs more than 8 bits.
+ * Such durations are stored as an escape code IR_RAW_ESCAPE + n with the value
+ * in longs[n]; a frame with more than IR_RAW_LONGS of them counts as overflow.
+ * Decoders read results.rawbuf[i] the same way in both modes.
+ */
+#if defined(IR_RAW_COMPACT)
+#if ! defined(IR_RAW_LONGS)
+#define IR_RAW_LONGS    2
+#endif
+#define IR_RAW_ESCAPE   (0x100 - IR_RAW_LONGS)  ///< first escape code, shorter durations are stored as is
+
+typedef uint8_t rawtick_t;
 
 /**
- * This struct is used for the ISR (interrupt service routine)
- * and is copied once only in state STATE_STOP, so only rcvstate needs to be volatile.
+ * Read only view of a compact rawbuf, expands escape codes on access.
+ */
+struct rawbuf_compact {
+    const uint8_t *raw;
+    const unsigned int *longs;
+    unsigned int operator[](unsigned int i) const {
+        uint8_t ticks = raw[i];
+        return ticks < IR_RAW_ESCAPE ? ticks : longs[ticks - IR_RAW_ESCAPE];
+    }
+};
+typedef struct rawbuf_compact rawbuf_t;
+#else
+typedef unsigned int rawtick_t;
+typedef unsigned int *rawbuf_t;
+#endif
+
+/**
+ * One captured frame.
+ */
+struct irframe_struct {
+    unsigned int rawlen;                     ///< counter of entries in rawbuf
+    rawtick_t rawbuf[RAW_BUFFER_LENGTH];     ///< raw data
+#if defined(IR_RAW_COMPACT)
+    uint8_t longcount;                       ///< entries used in longs
+    unsigned int longs[IR_RAW_LONGS];        ///< durations of IR_RAW_ESCAPE ticks and more
+#endif
+};
+
+/**
+ * This struct is used for the ISR (interrupt service routine).
+ * Slots between tail and head are complete and owned by the application,
+ * slot head is being recorded. head is only written by the ISR, tail only by resume().
  */
 struct irparams_struct {
     // The fields are ordered to reduce memory over caused by struct-padding
@@ -49,10 +126,15 @@ struct irparams_struct {
     uint8_t recvpin;                ///< Pin connected to IR data from detector
     uint8_t blinkpin;
     uint8_t blinkflag;              ///< true -> enable blinking of pin on IR processing
-    unsigned int rawlen;            ///< counter of entries in rawbuf
+    volatile uint8_t head;          ///< frames committed by the ISR, slot index modulo IR_FRAME_SLOTS
+    volatile uint8_t tail;          ///< frames released by resume()
     unsigned int timer;             ///< State timer, counts 50uS ticks.
-    unsigned int rawbuf[RAW_BUFFER_LENGTH];  ///< raw data
-    uint8_t overflow;               ///< Raw buffer overflow occurred
+    unsigned int overflows;         ///< frames discarded because they did not fit into rawbuf
+    unsigned int dropped;           ///< frames discarded because all slots were taken
+    struct irframe_struct frames[IR_FRAME_SLOTS];
+#if defined(IR_EDGE_CAPTURE)
+    unsigned long lastedge;         ///< micros() of the last edge
+#endif
 };
 
 extern struct irparams_struct irparams;
@@ -114,4 +196,168 @@ extern struct irparams_struct irparams;
 #define MARK   0 ///< Sensor output for a mark ("flash")
 #define SPACE  1 ///< Sensor output for a space ("gap")
 
+/**
+ * Append a duration to a frame, escaping it if it does not fit into rawtick_t.
+ * The caller checks rawlen against RAW_BUFFER_LENGTH.
+ * @return false if no room is left for a long duration.
+ */
+static inline bool irFramePut(struct irframe_struct *frame, unsigned int ticks) {
+#if defined(IR_RAW_COMPACT)
+    if (ticks >= IR_RAW_ESCAPE) {
+        if (frame->longcount >= IR_RAW_LONGS) {
+            return false;
+        }
+        frame->longs[frame->longcount] = ticks;
+        ticks = IR_RAW_ESCAPE + frame->longcount++;
+    }
+#endif
+    frame->rawbuf[frame->rawlen++] = ticks;
+    return true;
+}
+
+/**
+ * Start recording a frame into slot head, unless the application still holds all slots.
+ * @param gap Width of the space before the frame, becomes rawbuf[0].
+ * @return false if the frame is dropped.
+ */
+static inline bool irFrameStart(unsigned int gap) {
+    if ((uint8_t) (irparams.head - irparams.tail) >= IR_FRAME_SLOTS) {
+        irparams.dropped++;
+        return false;
+    }
+    struct irframe_struct *frame = &irparams.frames[irparams.head % IR_FRAME_SLOTS];
+    frame->rawlen = 0;
+#if defined(IR_RAW_COMPACT)
+    frame->longcount = 0;
+#endif
+    return irFramePut(frame, gap);
+}
+
+/**
+ * Append a duration to the frame being recorded.
+ * On overflow of rawbuf or longs the frame is discarded and the state machine goes back to IDLE.
+ * @return false if the frame overflowed.
+ */
+static inline bool irFrameStore(unsigned int ticks) {
+    struct irframe_struct *frame = &irparams.frames[irparams.head % IR_FRAME_SLOTS];
+    if (frame->rawlen >= RAW_BUFFER_LENGTH || !irFramePut(frame, ticks)) {
+        irparams.overflows++;
+        irparams.rcvstate = IR_REC_STATE_IDLE;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Hand the recorded frame to the application and wait for the next one.
+ */
+static inline void irFrameEnd() {
+    irparams.head++;
+    irparams.rcvstate = IR_REC_STATE_IDLE;
+}
+
+/**
+ * Receiver state machine, fed with one sample of the receiver output per tick.
+ * Shared by the library ISR and by IRrecvT::tickISR().
+ * Widths of alternating SPACE, MARK are recorded in the rawbuf of slot head.
+ * Recorded in ticks of 50uS [microseconds, 0.000050 seconds]
+ * First entry is the SPACE between transmissions.
+ * As soon as the last SPACE gets long:
+ *   The frame is committed; State switches to IDLE; Timing of SPACE continues.
+ * As soon as first MARK arrives:
+ *   Gap width is recorded; New logging starts in the next free slot
+ */
+static inline void irRecordTick(uint8_t irdata) {
+    irparams.timer++;  // One more 50uS tick
+
+    /*
+     * Due to a ESP32 compiler bug https://github.com/espressif/esp-idf/issues/1552 no switch statements are possible for ESP32
+     * So we change the code to if / else if
+     */
+//    switch (irparams.rcvstate) {
+    //......................................................................
+    if (irparams.rcvstate == IR_REC_STATE_IDLE) { // In the middle of a gap
+        if (irdata == MARK) {
+            // Gap just ended; Record gap duration; Start recording transmission.
+            // A short gap or a dropped frame just restarts the gap timer.
+            if (irparams.timer >= GAP_TICKS && irFrameStart(irparams.timer)) {
+                irparams.rcvstate = IR_REC_STATE_MARK;
+            }
+            irparams.timer = 0;
+        }
+    } else if (irparams.rcvstate == IR_REC_STATE_MARK) {  // Timing Mark
+        if (irdata == SPACE) {   // Mark ended; Record time
+            if (irFrameStore(irparams.timer)) {
+                irparams.rcvstate = IR_REC_STATE_SPACE;
+            }
+            irparams.timer = 0;
+        }
+    } else if (irparams.rcvstate == IR_REC_STATE_SPACE) {  // Timing Space
+        if (irdata == MARK) {  // Space just ended; Record time
+            if (irFrameStore(irparams.timer)) {
+                irparams.rcvstate = IR_REC_STATE_MARK;
+            }
+            irparams.timer = 0;
+
+        } else if (irparams.timer > GAP_TICKS) {  // Space
+            // A long Space, indicates gap between codes
+            // Commit the current code for processing
+            // Don't reset timer; keep counting Space width
+            irFrameEnd();
+        }
+    }
+}
+
+#if defined(IR_EDGE_CAPTURE)
+/**
+ * Edge capture counterpart of irRecordTick(), called from the INT0 ISR.
+ * @param irdata Receiver output after the edge.
+ */
+static inline void irRecordEdge(uint8_t irdata) {
+    unsigned long now = micros();
+    unsigned long ticks = (now - irparams.lastedge + MICROS_PER_TICK / 2) / MICROS_PER_TICK;
+    irparams.lastedge = now;
+    if (ticks > 0xFFFF) {
+        ticks = 0xFFFF;
+    }
+
+    if (irparams.rcvstate == IR_REC_STATE_IDLE) {
+        if (irdata == MARK && ticks >= GAP_TICKS && irFrameStart(ticks)) {
+            // Gap just ended; Record gap duration; Start recording transmission
+            irparams.rcvstate = IR_REC_STATE_MARK;
+        }
+        return;
+    }
+    // edges of the same level are glitches, keep timing the current one
+    if ((irparams.rcvstate == IR_REC_STATE_MARK) == (irdata == MARK)) {
+        return;
+    }
+    // Gap ended before irCheckGap() saw it (loop() was busy): commit the frame
+    // and start recording the next one, as irRecordTick() does on its timeout
+    if (irdata == MARK && ticks > GAP_TICKS) {
+        irFrameEnd();
+        if (irFrameStart(ticks)) {
+            irparams.rcvstate = IR_REC_STATE_MARK;
+        }
+        return;
+    }
+    if (irFrameStore(ticks)) {
+        irparams.rcvstate = irdata == MARK ? IR_REC_STATE_MARK : IR_REC_STATE_SPACE;
+    }
+}
+
+/**
+ * Finish the frame once the line stayed in space for longer than a gap.
+ * Called from the main context instead of the 50 us timeout of the timer ISR.
+ */
+static inline void irCheckGap() {
+    uint8_t oldSREG = SREG;
+    cli();
+    if (irparams.rcvstate == IR_REC_STATE_SPACE && micros() - irparams.lastedge > _GAP) {
+        irFrameEnd();
+    }
+    SREG = oldSREG;
+}
+#endif
+
 #endif
@@ -75,7 +75,6 @@ void IRrecv::enableIRIn() {
 
     // Initialize state machine variables
     irparams.rcvstate = IR_REC_STATE_IDLE;
-    irparams.rawlen = 0;
 
     // Set pin modes
     pinMode(irparams.recvpin, INPUT);
@@ -0,0 +1,220 @@
+#include "display.h"
+#include <util/atomic.h>
+
+static_assert((DISP_QUEUE & (DISP_QUEUE - 1)) == 0, "DISP_QUEUE must be a power of two");
+
+#define SEG_MASK_B (_BV(PB0) | _BV(PB1) | _BV(PB2) | _BV(PB3))
+#define SEG_MASK_D (_BV(PD5) | _BV(PD6) | _BV(PD7))
+#define GND_MASK_D (_BV(PD3) | _BV(PD4))
+
+// готовые значения портов для каждого разряда (вместе с битом разряда)
+typedef struct {
+  byte b[2];
+  byte d[2];
+} portStruct;
+
+static dispStruct dispState;
+// шрифт с 0x20, биты GFEDCBA
+static const byte font[] PROGMEM = {
+  B00000000, B00000000, B00100010, B00000000, B00000000, B00000000, B00000000, B00000010, //  !"#$%&'
+  B00111001, B00001111, B00000000, B00000000, B00000000, B01000000, B00000000, B01010010, // ()*+,-./
+  B00111111, B00000110, B01011011, B01001111, B01100110, B01101101, B01111101, B00000111, // 01234567
+  B01111111, B01100111, B00000000, B00000000, B00000000, B01001000, B00000000, B01010011, // 89:;<=>?
+  B00000000, B01110111, B01111100, B00111001, B01011110, B01111001, B01110001, B00111101, // @ABCDEFG
+  B01110110, B00000110, B00011110, B00000000, B00111000, B00000000, B01010100, B00111111, // HIJKLMNO
+  B01110011, B01100111, B01010000, B01101101, B01111000, B00111110, B00111110, B00000000, // PQRSTUVW
+  B00000000, B01101110, B01011011, B00111001, B00000000, B00001111, B00000000, B00001000, // XYZ[\]^_
+};
+
+static volatile portStruct dispPort;
+static volatile uint8_t dispDigit = 0;
+static volatile uint8_t dispBit = 0;
+static volatile byte dispLevel = DISP_BRIGHT_MAX;
+
+// загрузка: такты таймера внутри прерывания за окно из DISP_LOAD_DIGITS разрядов
+static uint16_t loadBusy = 0;
+static uint8_t loadDigits = 0;
+static volatile uint16_t loadTicks = 0;
+
+// бегущая строка
+static PGM_P queue[DISP_QUEUE];
+static uint8_t queueHead = 0;
+static uint8_t queueTail = 0;
+static PGM_P scrollMsg = NULL;
+static int8_t scrollPos;
+static unsigned long scrollMs;
+static dispStruct scrollSaved;    // что было на индикаторе до прокрутки
+
+static byte segToPortB(byte seg) {
+  byte b = 0;
+  if (seg & _BV(1)) b |= _BV(PB0); // B
+  if (seg & _BV(2)) b |= _BV(PB1); // C
+  if (seg & _BV(3)) b |= _BV(PB3); // D
+  if (seg & _BV(4)) b |= _BV(PB2); // E
+  return b;
+}
+
+static byte segToPortD(byte seg) {
+  byte d = 0;
+  if (seg & _BV(0)) d |= _BV(PD6); // A
+  if (seg & _BV(5)) d |= _BV(PD5); // F
+  if (seg & _BV(6)) d |= _BV(PD7); // G
+  return d;
+}
+
+static void show(byte d1, byte d2) {
+  byte b1 = segToPortB(d1);
+  byte b2 = segToPortB(d2);
+  byte p1 = segToPortD(d1) | _BV(PD3);
+  byte p2 = segToPortD(d2) | _BV(PD4);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    dispState.d1 = d1;
+    dispState.d2 = d2;
+    dispPort.b[0] = b1;
+    dispPort.b[1] = b2;
+    dispPort.d[0] = p1;
+    dispPort.d[1] = p2;
+  }
+}
+
+void displayInit() {
+  DDRB |= SEG_MASK_B;
+  DDRD |= SEG_MASK_D | GND_MASK_D;
+  show(dispState.d1, dispState.d2);
+
+  timebaseInit();
+  displayOn();
+}
+
+void displaySet(byte d1, byte d2) {
+  scrollMsg = NULL;
+  queueTail = queueHead;
+  show(d1, d2);
+}
+
+byte displayGlyph(char c) {
+  if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+  if (c < 0x20 || c > 0x5F) return 0;
+  return pgm_read_byte(&font[c - 0x20]);
+}
+
+void displayText(const char *s) {
+  byte d1 = displayGlyph(s[0]);
+  displaySet(d1, s[0] ? displayGlyph(s[1]) : 0);
+}
+
+void displayText_P(PGM_P s) {
+  char c = pgm_read_byte(s);
+  displaySet(displayGlyph(c), c ? displayGlyph(pgm_read_byte(s + 1)) : 0);
+}
+
+void displayNumber(int n) {
+  n = constrain(n, -9, 99);
+  if (n < 0) {
+    displaySet(displayGlyph('-'), displayGlyph('0' - n));
+  } else {
+    displaySet(n < 10 ? 0 : displayGlyph('0' + n / 10), displayGlyph('0' + n % 10));
+  }
+}
+
+bool displayScroll_P(PGM_P s) {
+  if ((uint8_t)(queueHead - queueTail) >= DISP_QUEUE) return false;
+  queue[queueHead++ % DISP_QUEUE] = s;
+  return true;
+}
+
+bool displayScrolling() {
+  return scrollMsg || queueHead != queueTail;
+}
+
+// символ сообщения в позиции i, перед началом пусто, '\0' в конце тоже пуст
+static byte scrollGlyph(int8_t i) {
+  if (i < 0) return 0;
+  return displayGlyph(pgm_read_byte(scrollMsg + i));
+}
+
+static void scrollStart() {
+  scrollMsg = queue[queueTail++ % DISP_QUEUE];
+  scrollPos = -1;
+}
+
+void displayTick() {
+  if (!scrollMsg) {
+    if (queueHead == queueTail) return;
+    // запоминается только изображение до первого сообщения, не хвост предыдущего
+    scrollSaved = dispState;
+    scrollStart();
+  } else if (millis() - scrollMs < DISP_SCROLL_MS) {
+    return;
+  } else if (!pgm_read_byte(scrollMsg + scrollPos + 1)) {
+    // последний символ ушёл в первый разряд, следующее сообщение или то, что было
+    if (queueHead == queueTail) {
+      scrollMsg = NULL;
+      show(scrollSaved.d1, scrollSaved.d2);
+      return;
+    }
+    scrollStart();
+  } else {
+    scrollPos++;
+  }
+  scrollMs = millis();
+  show(scrollGlyph(scrollPos), scrollGlyph(scrollPos + 1));
+}
+
+void displayOff() {
+  TIMSK1 &= ~_BV(OCIE1A);
+  PORTD &= ~GND_MASK_D;
+}
+
+void displayOn() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    OCR1A = TCNT1 + DISP_SLICE_TICKS;
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 |= _BV(OCIE1A);
+  }
+}
+
+void displaySetBrightness(byte level) {
+  dispLevel = min(level, (byte) DISP_BRIGHT_MAX);
+}
+
+uint16_t displayLoad() {
+  uint16_t t;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    t = loadTicks;
+  }
+  return (uint32_t) t * 1000 / ((uint32_t) DISP_LOAD_DIGITS * DISP_SLICE_TICKS * DISP_BRIGHT_MAX);
+}
+
+dispStruct displayGet() {
+  dispStruct s;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    s = dispState;
+  }
+  return s;
+}
+
+ISR(TIMER1_COMPA_vect) {
+  uint16_t t0 = TCNT1; // другие прерывания сюда не вклинятся, TEMP не испортят
+  uint8_t bit = dispBit + 1;
+  uint8_t i = dispDigit;
+  if (bit == DISP_BCM_BITS) {
+    bit = 0;
+    i ^= 1;
+    dispDigit = i;
+    if (++loadDigits == DISP_LOAD_DIGITS) {
+      loadDigits = 0;
+      loadTicks = loadBusy;
+      loadBusy = 0;
+    }
+  }
+  dispBit = bit;
+  OCR1A += (uint16_t) DISP_SLICE_TICKS << bit;
+  // гасим оба разряда до смены сегментов, иначе будет двоение
+  PORTD &= ~GND_MASK_D;
+  if (dispLevel & _BV(bit)) {
+    PORTB = (PORTB & ~SEG_MASK_B) | dispPort.b[i];
+    PORTD = (PORTD & ~(SEG_MASK_D | GND_MASK_D)) | dispPort.d[i];
+  }
+  loadBusy += TCNT1 - t0;
+}
@@ -0,0 +1,171 @@
+#include "keymap.h"
+#include <avr/eeprom.h>
+#include "storage.h"
+
+typedef struct {
+  uint8_t remote;
+  uint32_t code;
+  uint8_t key;
+} keyMapEntry;
+
+// описание пультов, порядок строк не важен
+constexpr keyMapEntry keyTable[] = {
+  {REMOTE_ANY,     4294967295, KEY_REPEAT},
+
+  {REMOTE_CAR_MP3, 16460501,   KEY_MUTE},
+  {REMOTE_CAR_MP3, 16476311,   KEY_INPUT_CH},
+  {REMOTE_CAR_MP3, 16486511,   KEY_VOL_UP},
+  {REMOTE_CAR_MP3, 16490591,   KEY_VOL_DOWN},
+  {REMOTE_CAR_MP3, 16494671,   KEY_BASS_UP},
+  {REMOTE_CAR_MP3, 16462541,   KEY_BASS_DOWN},
+  {REMOTE_CAR_MP3, 16484471,   KEY_TREB_UP},
+  {REMOTE_CAR_MP3, 16452341,   KEY_TREB_DOWN},
+
+  {REMOTE_SOLO7C,  2155823295, KEY_MUTE},
+  {REMOTE_SOLO7C,  2155815135, KEY_INPUT_CH},
+  {REMOTE_SOLO7C,  2155841655, KEY_VOL_UP},
+  {REMOTE_SOLO7C,  2155809015, KEY_VOL_DOWN},
+  {REMOTE_SOLO7C,  2155827375, KEY_BASS_UP},
+  {REMOTE_SOLO7C,  2155835535, KEY_BASS_DOWN},
+  {REMOTE_SOLO7C,  2155843695, KEY_TREB_UP},
+  {REMOTE_SOLO7C,  2155851855, KEY_TREB_DOWN},
+};
+
+constexpr bool keyEnabled(const keyMapEntry &e) {
+  return e.remote == REMOTE_ANY || (KEYMAP_REMOTES & _BV(e.remote));
+}
+
+constexpr uint8_t keyCount() {
+  uint8_t n = 0;
+  for (const keyMapEntry &e : keyTable) {
+    if (keyEnabled(e)) n++;
+  }
+  return n;
+}
+
+#define KEYMAP_SIZE keyCount()
+
+// коды и кнопки лежат раздельно, чтобы поиск читал из flash только коды
+typedef struct {
+  uint32_t code[KEYMAP_SIZE];
+  uint8_t key[KEYMAP_SIZE];
+} keyIndexStruct;
+
+// выбрать коды включённых пультов и отсортировать их вставками
+constexpr keyIndexStruct keyIndexBuild() {
+  keyIndexStruct t{};
+  uint8_t n = 0;
+  for (const keyMapEntry &e : keyTable) {
+    if (!keyEnabled(e)) continue;
+    uint8_t i = n++;
+    while (i > 0 && t.code[i - 1] > e.code) {
+      t.code[i] = t.code[i - 1];
+      t.key[i] = t.key[i - 1];
+      i--;
+    }
+    t.code[i] = e.code;
+    t.key[i] = e.key;
+  }
+  return t;
+}
+
+constexpr bool keyIndexUnique(const keyIndexStruct &t) {
+  for (uint8_t i = 1; i < KEYMAP_SIZE; i++) {
+    if (t.code[i - 1] == t.code[i]) return false;
+  }
+  return true;
+}
+
+constexpr keyIndexStruct keyIndex PROGMEM = keyIndexBuild();
+static_assert(keyIndexUnique(keyIndexBuild()), "duplicate IR code in keyTable");
+
+static_assert((KEYMAP_CACHE_SIZE & (KEYMAP_CACHE_SIZE - 1)) == 0, "KEYMAP_CACHE_SIZE must be a power of two");
+static_assert(KEYMAP_CACHE_SIZE > KEYMAP_LEARN_MAX, "KEYMAP_CACHE_SIZE too small");
+
+#define LEARN_MAGIC 0xA5
+
+typedef struct {
+  uint32_t code;
+  uint8_t key;
+} learnEntry;
+
+static uint8_t eeLearnMagic EEMEM;
+static uint8_t eeLearnCount EEMEM;
+static learnEntry eeLearn[KEYMAP_LEARN_MAX] EEMEM;
+
+static learnEntry learned[KEYMAP_LEARN_MAX]; // копия EEPROM в том же порядке
+static uint8_t learnedCount = 0;
+static uint8_t learnSlot[KEYMAP_CACHE_SIZE]; // индекс в learned + 1, 0 - пусто
+
+static uint8_t learnHash(uint32_t code) {
+  // у NEC в старших байтах адрес пульта, команда в младших
+  uint8_t h = (uint8_t)code ^ (uint8_t)(code >> 8) ^ (uint8_t)(code >> 16) ^ (uint8_t)(code >> 24);
+  return h & (KEYMAP_CACHE_SIZE - 1);
+}
+
+// слот с этим кодом или первый пустой слот на его пути
+static uint8_t learnProbe(uint32_t code) {
+  uint8_t h = learnHash(code);
+  while (learnSlot[h] && learned[learnSlot[h] - 1].code != code) {
+    h = (h + 1) & (KEYMAP_CACHE_SIZE - 1);
+  }
+  return h;
+}
+
+void keymapInit() {
+  learnedCount = 0;
+  memset(learnSlot, 0, sizeof(learnSlot));
+  if (eeprom_read_byte(&eeLearnMagic) != LEARN_MAGIC) return;
+  uint8_t n = eeprom_read_byte(&eeLearnCount);
+  if (n > KEYMAP_LEARN_MAX) return;
+  eeprom_read_block(learned, eeLearn, n * sizeof(learnEntry));
+  for (uint8_t i = 0; i < n; i++) {
+    learnSlot[learnProbe(learned[i].code)] = i + 1;
+  }
+  learnedCount = n;
+}
+
+bool keymapLearn(uint32_t irCode, uint8_t key) {
+  uint8_t h = learnProbe(irCode);
+  uint8_t i;
+  if (learnSlot[h]) {
+    i = learnSlot[h] - 1;
+  } else {
+    if (learnedCount >= KEYMAP_LEARN_MAX) return false;
+    i = learnedCount++;
+    learned[i].code = irCode;
+    learnSlot[h] = i + 1;
+  }
+  learned[i].key = key;
+  storageWait();
+  eeprom_update_block(&learned[i], &eeLearn[i], sizeof(learnEntry));
+  eeprom_update_byte(&eeLearnCount, learnedCount);
+  eeprom_update_byte(&eeLearnMagic, LEARN_MAGIC);
+  return true;
+}
+
+void keymapForget() {
+  learnedCount = 0;
+  memset(learnSlot, 0, sizeof(learnSlot));
+  storageWait();
+  eeprom_update_byte(&eeLearnCount, 0);
+  eeprom_update_byte(&eeLearnMagic, LEARN_MAGIC);
+}
+
+uint8_t keymapFind(uint32_t irCode) {
+  // выученные коды важнее встроенных
+  uint8_t h = learnProbe(irCode);
+  if (learnSlot[h]) return learned[learnSlot[h] - 1].key;
+
+  // бинарный поиск, для 17 кодов не больше 5 сравнений
+  uint8_t lo = 0;
+  uint8_t hi = KEYMAP_SIZE;
+  while (lo < hi) {
+    uint8_t mid = (lo + hi) >> 1;
+    uint32_t c = pgm_read_dword(&keyIndex.code[mid]);
+    if (c == irCode) return pgm_read_byte(&keyIndex.key[mid]);
+    if (c < irCode) lo = mid + 1;
+    else hi = mid;
+  }
+  return KEY_UNDEFINED;
+}
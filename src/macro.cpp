@@ -0,0 +1,41 @@
+#include "macro.h"
+#include <avr/pgmspace.h>
+#include "state.h"
+
+// PC, громкость 25, бас 2, ВЧ 0. Бас задаётся, а не прибавляется
+// (MACRO_ADD): повторное нажатие даёт ту же сцену, а не копит бас
+static const byte macroPC[] PROGMEM = {
+  MACRO_SET | STATE_INPUT, PC,
+  MACRO_SET | STATE_MUTE, 0,
+  MACRO_SET | STATE_VOLUME, 25,
+  MACRO_SET | STATE_BASS, 2,
+  MACRO_SET | STATE_TREBLE, 0,
+  MACRO_END
+};
+
+// AUX тихо и без тембров
+static const byte macroQuiet[] PROGMEM = {
+  MACRO_SET | STATE_INPUT, AUX,
+  MACRO_SET | STATE_MUTE, 0,
+  MACRO_SET | STATE_VOLUME, 12,
+  MACRO_SET | STATE_BASS, 0,
+  MACRO_SET | STATE_TREBLE, 0,
+  MACRO_END
+};
+
+static const byte *const macros[] PROGMEM = {macroPC, macroQuiet};
+
+static_assert(sizeof(macros) / sizeof(macros[0]) == MACRO_COUNT, "MACRO_COUNT must match the macros table");
+
+bool macroRun(uint8_t n) {
+  if (n >= MACRO_COUNT) return false;
+  const byte *p = (const byte *) pgm_read_ptr(&macros[n]);
+  for (;;) {
+    byte op = pgm_read_byte(p++);
+    if (op == MACRO_END) break;
+    int8_t value = pgm_read_byte(p++);
+    uint8_t field = op & ~MACRO_ADD;
+    stateSetField(field, op & MACRO_ADD ? stateGetField(field) + value : value);
+  }
+  return true;
+}
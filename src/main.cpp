@@ -1,113 +1,160 @@
 #include <Arduino.h>
 #include "GyverTimer.h"
+#define EB_FIFO_SIZE 16 // повороты из прерывания копятся здесь, пока loop занят
 #include "EncButton.h"
 #include "IRremote.h"
-#include <Wire.h>
 #include <avr/pgmspace.h>
-
-#define KEY_UNDEFINED 0
-#define KEY_REPEAT    1
-#define KEY_MUTE      2
-#define KEY_VOL_UP    3
-#define KEY_VOL_DOWN  4
-#define KEY_BASS_UP   5
-#define KEY_BASS_DOWN 6
-#define KEY_TREB_UP   7
-#define KEY_TREB_DOWN 8
-#define KEY_INPUT_CH  9
-#define KEY_RESET     10
-
-#define DISP_DELAY 1
-
-//
-//                            --A--
-//                         F |     | B
-//                           |--G--|
-//                         E |     | C
-//                            --D--
-//                   {A, B, C, D, E,   F, G};
-int segmentPins[7] = {6, 8, 9, 11, 10, 5, 7};
-#define gnd1 3
-#define gnd2 4
-
-#define MAX_VOLUME 60
-#define ADR 0x41 // адрес MCU I2C
-
-enum INPUTS { AUX, PC};
-
-IRrecv IrReceiver(2); // вывод, к которому подключен приемник
+#include "display.h"
+#include "mcu.h"
+#include "ramp.h"
+#include "volcurve.h"
+#include "keymap.h"
+#include "storage.h"
+#include "profiler.h"
+#include "protocol.h"
+#include "telemetry.h"
+#include "power.h"
+#include "state.h"
+#include "modes.h"
+#include "macro.h"
+
+#define ENC_ACCEL_MS  60 // щелчки чаще этого ускоряются
+#define ENC_ACCEL_MAX 5  // шагов за щелчок при самом быстром вращении
+#define DIM_IDLE_MS 30000 // без действий дольше этого индикация приглушается
+#define DIM_LEVEL 2       // яркость в ночном режиме (mute или простой), из DISP_BRIGHT_MAX
+
+// поля состояния, на которые подписан каждый получатель
+#define MCU_VOL_FIELDS (STATE_F_VOLUME | STATE_F_INPUT | STATE_F_MUTE) // регистры L, R, вход
+#define MCU_EQ_FIELDS  (STATE_F_BASS | STATE_F_TREBLE)                 // регистр EQ
+#define DISP_FIELDS    (STATE_F_MUTE | STATE_F_VOLUME | STATE_F_BASS | STATE_F_TREBLE | STATE_F_INPUT) // прочерки и строки modes.cpp
+#define SAVE_FIELDS    STATE_F_PACKED // запись EEPROM - это statePack()
+#define REPORT_FIELDS  STATE_F_PACKED // TELE_STATE несёт statePack()
+
+IRrecvT<2> IrReceiver; // вывод, к которому подключен приемник
 EncButton eb(A3, A2, A1); // pin энкодера
-int encMode = 0;
+uint8_t encMode = 0; // строка таблицы режимов, см. modes.h
+
+// кнопки, которые можно выучить, по порядку обучения
+const uint8_t learnKeys[] = {KEY_MUTE, KEY_INPUT_CH, KEY_VOL_UP, KEY_VOL_DOWN,
+                             KEY_BASS_UP, KEY_BASS_DOWN, KEY_TREB_UP, KEY_TREB_DOWN,
+                             KEY_MACRO, KEY_MACRO + 1};
+#define LEARN_KEYS (sizeof(learnKeys) / sizeof(learnKeys[0]))
+int learnMode = -1; // номер обучаемой кнопки, -1 обучение выключено
+unsigned int learnOverflows; // IrReceiver.getOverflows() на момент обучения
+byte mcuRegs[MCU_REGS]; // регистры MCU по состоянию, группы пересчитывает syncMCU()
 
 decode_results irRecieveResults;
 GTimer timeOutToDisplayVolume;
 
+static_assert(STORAGE_DATA_LEN == STATE_PACKED_LEN, "state must fit a storage record");
 
-typedef struct {
-  bool isMute = true;
-  INPUTS inputCh = AUX;
-  int bass = 0;
-  int treble = 0;
-  int volume = 20;
-} stateStruct;
-
-typedef struct {
-  //          GFEDCBA
-  byte d1 = B01000000;
-  byte d2 = B01000000;
-} dispStruct;
-
-stateStruct avrState;
-dispStruct dispState;
-
-void displayTick();
-void displaySetInt(int i);
-void displaySetDigit_Config(int i);
-void setInputAndDisplayAUX();
-void setInputAndDisplayPC();
-void processKey(unsigned long key);
-int getKeyByCode(unsigned long irCode);
+void displayLabel(char c, int i);
+void processKey(unsigned long key, int steps = 1);
+int getKeyByCode(unsigned long irCode, int protocol);
 void processOneEventKey(unsigned long irCode);
-void syncMCU();
-stateStruct setMCUState(stateStruct newState);
+void syncMCU(uint8_t changed, const stateStruct &s);
+void setMCUState(const stateStruct &s);
+void mcuVolumeRegs(const stateStruct &s);
+void mcuEqReg(const stateStruct &s);
 void switchMute();
-void switchInputCh();
 void irReceiveTick();
 void encoderTick();
+void serialCommand(uint8_t cmd, const byte *data, uint8_t len);
+void sendState();
+void stateLoad();
+void stateSave(uint8_t changed, const stateStruct &s);
+void displayState(uint8_t changed, const stateStruct &s);
+void reportState(uint8_t changed, const stateStruct &s);
+void learnStart();
+void learnStop();
+void learnEncoderTick();
+void learnIrTick(unsigned long irCode);
+void learnShow();
 
 void setup() {
   timeOutToDisplayVolume.setTimeout(3000);
-  for (uint8_t i = 0; i < 7; i++) {
-    pinMode(segmentPins[i], OUTPUT);
-  }
-  pinMode(gnd1, OUTPUT);
-  pinMode(gnd2, OUTPUT);
-
-  Wire.begin();
+  displayInit();
+
+  stateLoad();
+  mcuInit();
+  setMCUState(stateGet());
+  if (!stateGet().isMute) displayNumber(stateGet().volume);
+  stateSubscribe(MCU_VOL_FIELDS | MCU_EQ_FIELDS, syncMCU);
+  stateSubscribe(DISP_FIELDS, displayState);
+  stateSubscribe(SAVE_FIELDS, stateSave);
+  stateSubscribe(REPORT_FIELDS, reportState);
+  keymapInit();
   IrReceiver.enableIRIn();
   eb.setEncType(EB_STEP4_LOW);
+  eb.setEncAccel(ENC_ACCEL_MS, ENC_ACCEL_MAX);
+  // энкодер A3, A2 - PC3, PC2 (PCINT11, PCINT10), щелчки ловим в прерывании
+  eb.setEncISR(true);
+  PCMSK1 |= _BV(PCINT10) | _BV(PCINT11);
+  PCICR |= _BV(PCIE1);
+
+  protoBegin(serialCommand);
+  powerInit();
+}
 
-  Serial.begin(9600);
+ISR(PCINT1_vect) {
+  eb.tickISR();
 }
 
+#ifndef IR_EDGE_CAPTURE
+// приёмник ИК опрашивается каждые 50 мкс, вывод известен при сборке (IR_USER_ISR)
+ISR(TIMER_INTR_NAME) {
+  IrReceiver.tickISR();
+}
+#endif
+
 void loop() {
+  PROF_BEGIN();
   encoderTick();
+  PROF_MARK(PROF_ENCODER);
   irReceiveTick();
-
-  syncMCU();  
-
-  if (timeOutToDisplayVolume.isReady() && avrState.isMute == false) {
-    displaySetInt(avrState.volume);
+  PROF_MARK(PROF_IR);
+  // все команды из буфера применяются до stateTick() и уйдут одной записью
+  protoTick();
+
+  stateTick();
+  telemetryTick();
+  mcuTick();
+  storageTick();
+  PROF_MARK(PROF_SYNC);
+
+  if (timeOutToDisplayVolume.isReady() && !stateGet().isMute && learnMode < 0) {
+    displayNumber(stateGet().volume);
     encMode = 0;
   }
-
   displayTick();
+  bool dim = stateGet().isMute || powerIdleMs() > DIM_IDLE_MS;
+  displaySetBrightness(dim ? DIM_LEVEL : DISP_BRIGHT_MAX);
+  PROF_MARK(PROF_DISPLAY);
+
+  PROF_TICK();
+  PROF_END();
+
+  powerTick(stateGet().isMute && learnMode < 0 && !mcuBusy() && !rampActive() && !storageBusy()
+            && !storagePending() && !displayScrolling()
+            && telemetryIdle() && !PROF_BUSY() && !Serial.available());
 }
 
 void encoderTick(){
   eb.tick();
+  if (eb.busy() || eb.turn()) powerActivity(); // повороты кнопку не занимают
+
+  if (learnMode >= 0) {
+    learnEncoderTick();
+    return;
+  }
+
+  // клик и удержание - обучение пульту
+  if (eb.hold(1)) {
+    learnStart();
+    return;
+  }
   
-  if(avrState.isMute) {
+  if(stateGet().isMute) {
     if (eb.turn()){
       processKey(KEY_MUTE);
     }
@@ -115,47 +162,39 @@ void encoderTick(){
   }
   
   if (eb.click()){
-      encMode++;
-      if (encMode >3) encMode=0;
-      displaySetDigit_Config(encMode);
+      encMode = (encMode + 1) % MODE_COUNT;
+      displayLabel('C', encMode);
   }
   
-  if(encMode == 0){
-    if (eb.turn()){
-      if(eb.dir()>0) processKey(KEY_VOL_UP);
-      if(eb.dir()<0) processKey(KEY_VOL_DOWN);
-    }
-  }
-  if(encMode == 1){
-    if (eb.turn()){
-      if(eb.dir()>0) processKey(KEY_BASS_UP);
-      if(eb.dir()<0) processKey(KEY_BASS_DOWN);
-    }
-  }
-  if(encMode == 2){
-    if (eb.turn()){
-      if(eb.dir()>0) processKey(KEY_TREB_UP);
-      if(eb.dir()<0) processKey(KEY_TREB_DOWN);
-    }
-  }
-  if(encMode == 3){
-    if (eb.turn()){
-      processKey(KEY_INPUT_CH);
-    }
+  if (eb.turn()){
+    modeTurn(encMode, eb.delta());
   }
 
   // кнопка удерживается, смотрим сколько
   if (eb.holdFor()>1000) {
     stateStruct defaultState;
-    avrState = defaultState;
+    stateSet(defaultState);
   }
 }
 
 void irReceiveTick(){
 
   static unsigned long nextReadyTime = 0;
+  if (learnMode >= 0 && IrReceiver.getOverflows() != learnOverflows) {
+    // кадр длиннее RAW_BUFFER_LENGTH отброшен: пульт с таким протоколом не выучить
+    learnOverflows = IrReceiver.getOverflows();
+    displayScroll_P(PSTR("LONG"));
+  }
   if (IrReceiver.decode(&irRecieveResults)) { // если данные пришли
-    int key = getKeyByCode(irRecieveResults.value);
+    powerActivity();
+    if (learnMode >= 0) {
+      if (irRecieveResults.decode_type != UNKNOWN && irRecieveResults.value != REPEAT) {
+        learnIrTick(irRecieveResults.value);
+      }
+      IrReceiver.resume();
+      return;
+    }
+    int key = getKeyByCode(irRecieveResults.value, irRecieveResults.decode_type);
     if (nextReadyTime < millis()) {
       processKey(key);
       nextReadyTime =  millis() + 200;
@@ -166,220 +205,217 @@ void irReceiveTick(){
   }
 }
 
-void displayTick() {
-  for (int i = 0; i < 7; i++) {
-    digitalWrite(segmentPins[i], (dispState.d1 >> i) & 1u);
+void serialCommand(uint8_t cmd, const byte *data, uint8_t len) {
+  powerActivity();
+  switch (cmd) {
+    case PROTO_GET_STATE:
+      break;
+    case PROTO_SET_STATE: {
+      if (len != 6) {
+        protoSend(PROTO_NAK, &cmd, 1);
+        return;
+      }
+      uint8_t mask = data[0];
+      if (mask & PROTO_F_VOLUME) stateSetVolume(data[1]);
+      if (mask & PROTO_F_BASS) stateSetBass((int8_t) data[2]);
+      if (mask & PROTO_F_TREBLE) stateSetTreble((int8_t) data[3]);
+      if (mask & PROTO_F_INPUT) stateSetInput(data[4] ? PC : AUX);
+      if (mask & PROTO_F_MUTE) stateSetMute(data[5]);
+      break;
+    }
+    case PROTO_GET_STATS: {
+      mcuStatsStruct m = mcuGetStats();
+      protoStatsStruct p = protoGetStats();
+      powerStatsStruct w = powerGetStats();
+      uint16_t v[] = {m.done, m.errors, m.timeouts, m.merged,
+                      p.frames, p.badFrames, p.txDropped, telemetryDropped(),
+                      w.sleeps, w.wakeups, eb.lostTurns(), displayLoad(),
+                      IrReceiver.getOverflows(), IrReceiver.getDropped(), m.gaveUp};
+      static_assert(sizeof(v) <= PROTO_MAX_REPLY, "PROTO_STATS is the longest reply");
+      protoSend(PROTO_STATS, (const byte *) v, sizeof(v));
+      return;
+    }
+#ifdef PROFILER
+    case PROTO_PROF_DUMP:
+      profDump();
+      return;
+#endif
+    default:
+      protoSend(PROTO_NAK, &cmd, 1);
+      return;
   }
-  digitalWrite(gnd1, HIGH);
-  digitalWrite(gnd2, LOW); 
-  delay(DISP_DELAY);
-  digitalWrite(gnd1, LOW);
-  digitalWrite(gnd2, LOW);
-  for (int i = 0; i < 7; i++) {
-    digitalWrite(segmentPins[i], (dispState.d2 >> i) & 1u);
+  sendState();
+}
+
+void sendState() {
+  const stateStruct &s = stateGet();
+  byte data[5];
+  data[0] = s.volume;
+  data[1] = s.bass;
+  data[2] = s.treble;
+  data[3] = s.inputCh == PC ? 1 : 0;
+  data[4] = s.isMute;
+  protoSend(PROTO_STATE, data, sizeof(data));
+}
+
+// до подписки, загруженное состояние никуда не рассылается
+void stateLoad() {
+  byte data[STORAGE_DATA_LEN];
+  if (!storageLoad(data)) return;
+  stateStruct s;
+  stateUnpack(data, &s);
+  stateSet(s);
+  stateTick();
+}
+
+void stateSave(uint8_t changed, const stateStruct &s) {
+  byte data[STORAGE_DATA_LEN];
+  statePack(s, data);
+  storageSet(data);
+}
+
+// что показать: mute - прочерки, иначе последнее изменённое поле
+void displayState(uint8_t changed, const stateStruct &s) {
+  if (learnMode >= 0) return;
+  if (s.isMute) {
+    displayText_P(PSTR("--"));
+  } else if (changed & (STATE_F_VOLUME | STATE_F_MUTE)) {
+    displayNumber(s.volume);
+  } else {
+    uint8_t field = 0;
+    while (!(changed & _BV(field))) field++;
+    modeShow(field);
   }
-  digitalWrite(gnd1, LOW);
-  digitalWrite(gnd2, HIGH);
-  delay(DISP_DELAY);
-  digitalWrite(gnd1, LOW);
-  digitalWrite(gnd2, LOW);
+  timeOutToDisplayVolume.start();
 }
 
-void setInputAndDisplayAUX() {
-  avrState.inputCh = AUX;
-  dispState.d1 = B01110111;
-  dispState.d2 = B00111110;
+void reportState(uint8_t changed, const stateStruct &s) {
+  byte data[STATE_PACKED_LEN];
+  statePack(s, data);
+  uint32_t code;
+  memcpy(&code, data, sizeof(code));
+  telemetryPush(TELE_STATE, changed, code);
 }
 
-void setInputAndDisplayPC() {
-  avrState.inputCh = PC;
-  dispState.d1 = B01110011;
-  dispState.d2 = B00111001;
+void learnStart() {
+  learnMode = 0;
+  learnOverflows = IrReceiver.getOverflows();
+  learnShow();
 }
 
-void switchMute() {
-  avrState.isMute = !avrState.isMute;
-  if (avrState.isMute) {
-    dispState.d1 = B01000000;
-    dispState.d2 = B01000000;
+void learnStop() {
+  learnMode = -1;
+  encMode = 0;
+  if (stateGet().isMute) {
+    displayText_P(PSTR("--"));
   } else {
-    displaySetInt(avrState.volume);
+    displayNumber(stateGet().volume);
   }
 }
 
-void switchInputCh() {
-  switch (avrState.inputCh) {
-  case AUX:
-    setInputAndDisplayPC();
-    break;
-  case PC:
-    setInputAndDisplayAUX();
-    break;
+// поворот - выбор кнопки, клик - выход, удержание - забыть все выученные коды
+void learnEncoderTick() {
+  if (eb.turn()) {
+    learnMode = (learnMode + LEARN_KEYS + eb.dir()) % LEARN_KEYS;
+    learnShow();
+  }
+  if (eb.click()) {
+    learnStop();
+  }
+  if (eb.hold(0)) {
+    keymapForget();
+    learnMode = 0;
+    learnShow();
   }
 }
 
-void displaySetInt(int i) {
-  static const byte nums[10] = {B00111111, B00000110, B01011011, B01001111,
-                                B01100110, B01101101, B01111101, B00000111,
-                                B01111111, B01100111};
-  i = constrain(i, -9, 99);
-  if (i < 0) {
-    dispState.d1 = B01000000; // минус
-    dispState.d2 = nums[abs(i)];
-  } else if (i < 10) {
-    dispState.d1 = B00000000; // погашен
-    dispState.d2 = nums[abs(i)];
+// L1..L8 - кнопки, P1, P2 - макросы
+void learnShow() {
+  uint8_t key = learnKeys[learnMode];
+  if (key >= KEY_MACRO) {
+    displayLabel('P', key - KEY_MACRO + 1);
   } else {
-    dispState.d1 = nums[abs(i) / 10];
-    dispState.d2 = nums[abs(i) % 10];
+    displayLabel('L', learnMode + 1);
+  }
+}
+
+void learnIrTick(unsigned long irCode) {
+  if (!keymapLearn(irCode, learnKeys[learnMode])) {
+    displayScroll_P(PSTR("FULL")); // память заполнена
+    return;
   }
+  if (++learnMode >= (int) LEARN_KEYS) {
+    learnStop();
+    return;
+  }
+  learnShow();
+}
+
+void switchMute() {
+  stateSetMute(!stateGet().isMute);
 }
 
-void displaySetDigit_Config(int i) {
-  static const byte nums[10] = {B00111111, B00000110, B01011011, B01001111,
-                                B01100110, B01101101, B01111101, B00000111,
-                                B01111111, B01100111};
-  i = constrain(i, 0, 9);
-  dispState.d1 = B00111001; // C
-  dispState.d2 = nums[abs(i)];
+// буква режима и цифра: C1, L3
+void displayLabel(char c, int i) {
+  char s[] = {c, (char) ('0' + constrain(i, 0, 9)), 0};
+  displayText(s);
 }
 
-void processKey(unsigned long key) {
+void processKey(unsigned long key, int steps) {
   
-  if (avrState.isMute && key != KEY_MUTE) return;
+  // макрос может и включить звук, удержание его не повторяет
+  if (key >= KEY_MACRO) {
+    macroRun(key - KEY_MACRO);
+    key = KEY_UNDEFINED;
+  }
+
+  if (stateGet().isMute && key != KEY_MUTE) return;
   
   static unsigned long lastKey = 0;
 
-  if(key != KEY_REPEAT){
-    lastKey = key;
-    // обработка команд которые НЕ ДОЛЖНЫ поддерживать удержание
-    switch (lastKey) {
-      case KEY_INPUT_CH:
-        switchInputCh();
-        break;
-      case KEY_MUTE:
-        switchMute();
-        break;
-      }
-  }
-   
-  switch (lastKey) {
-    case KEY_VOL_UP:
-      avrState.volume++;
-      avrState.volume = constrain(avrState.volume, 0, MAX_VOLUME);
-      displaySetInt(avrState.volume);
-      break;
-    case KEY_VOL_DOWN:
-      avrState.volume--;
-      avrState.volume = constrain(avrState.volume, 0, MAX_VOLUME);
-      displaySetInt(avrState.volume);
-      break;
-    case KEY_BASS_UP:
-      avrState.bass++;
-      avrState.bass = constrain(avrState.bass, -7, 7);
-      displaySetInt(avrState.bass);
-      break;
-    case KEY_BASS_DOWN:
-      avrState.bass--;
-      avrState.bass = constrain(avrState.bass, -7, 7);
-      displaySetInt(avrState.bass);
-      break;
-    case KEY_TREB_UP:
-      avrState.treble++;
-      avrState.treble = constrain(avrState.treble, -7, 7);
-      displaySetInt(avrState.treble);
-      break;
-    case KEY_TREB_DOWN:
-      avrState.treble--;
-      avrState.treble = constrain(avrState.treble, -7, 7);
-      displaySetInt(avrState.treble);
-      break;
+  bool repeat = key == KEY_REPEAT;
+  if (!repeat) lastKey = key;
+  // mute не поддерживает удержание, остальное описано в таблице режимов
+  if (lastKey == KEY_MUTE) {
+    if (!repeat) switchMute();
+    return;
   }
+  modeKey(lastKey, steps, repeat);
 }
 
-int getKeyByCode(unsigned long irCode){
-  switch(irCode){
-    case 16460501: 
-    case 2155823295: // original Solo 7C
-      return KEY_MUTE;
-    case 16476311: 
-    case 2155815135: // original Solo 7C
-      return KEY_INPUT_CH;
-    case 16486511: 
-    case 2155841655: // original Solo 7C
-      return KEY_VOL_UP;
-    case 16490591: 
-    case 2155809015: // original Solo 7C
-      return KEY_VOL_DOWN;
-    case 16494671: 
-    case 2155827375: // original Solo 7C
-      return KEY_BASS_UP;
-    case 16462541: 
-    case 2155835535: // original Solo 7C
-      return KEY_BASS_DOWN;
-    case 16484471: 
-    case 2155843695: // original Solo 7C
-      return KEY_TREB_UP;
-    case 16452341: 
-    case 2155851855: // original Solo 7C
-      return KEY_TREB_DOWN;
-    case 4294967295: 
-      return KEY_REPEAT;
-    default: 
-      Serial.print("not defined case for code ");
-      Serial.println(irCode);
-      return KEY_UNDEFINED;
+int getKeyByCode(unsigned long irCode, int protocol){
+  uint8_t key = keymapFind(irCode);
+  if (key == KEY_UNDEFINED) {
+    telemetryPush(TELE_UNKNOWN_CODE, protocol, irCode);
   }
+  return key;
 }
 
- void syncMCU(){
-  static stateStruct mcuState = avrState;
-  if (mcuState.volume != avrState.volume) goto needUpdate;
-  if (mcuState.bass != avrState.bass) goto needUpdate;
-  if (mcuState.treble != avrState.treble) goto needUpdate;
-  if (mcuState.inputCh != avrState.inputCh) goto needUpdate;
-  if (mcuState.isMute != avrState.isMute) goto needUpdate;  
-  return;
-  needUpdate:
-    mcuState = setMCUState(avrState);
-    timeOutToDisplayVolume.start();
- }
-
-stateStruct setMCUState(stateStruct avrState) {
-  Wire.beginTransmission(ADR);
-  Wire.write(0); // write mode
-
+// регистры громкости и входа, MCU_VOL_FIELDS
+void mcuVolumeRegs(const stateStruct &avrState) {
   // VOLUME
-  if (avrState.volume <= 0) {
-    Wire.write(255); // Data L
-    Wire.write(255); // Data R
-  } else {
-    int vol = 96 - ((float) avrState.volume * 1.6f);
-    Wire.write(vol); // Data L
-    Wire.write(vol); // Data R
-  }
+  byte vol = volToReg(avrState.volume);
+  mcuRegs[MCU_REG_VOL_L] = vol; // Data L
+  mcuRegs[MCU_REG_VOL_R] = vol; // Data R
 
   // INPUT
   // todo if mainState.volume = 0 to MUTE
   if (avrState.isMute) {
-    Wire.write(B11100000);
+    mcuRegs[MCU_REG_INPUT] = MCU_INPUT_MUTE;
   } else {
     switch (avrState.inputCh) {
     case AUX:
-      Wire.write(B00000000);
+      mcuRegs[MCU_REG_INPUT] = B00000000;
       break;
     case PC:
-      Wire.write(B00100000);
+      mcuRegs[MCU_REG_INPUT] = B00100000;
       break;
     }
   }
-  // Stereo    00 | Bypass              00  |   0000
-  // Lch Mono  01 | Tone                01  |   0000
-  // Rch Mono  10 | Tone & Surround Hi  10  |   0000
-  //              | Tone & Surround Low 11  |   0000
-  Wire.write(B00010000);
+}
 
-  // EQ
+// регистр EQ, MCU_EQ_FIELDS
+void mcuEqReg(const stateStruct &avrState) {
   byte bass = B00000000;
   if (avrState.bass > 0) {
     bass = B10000000;
@@ -392,8 +428,23 @@ stateStruct setMCUState(stateStruct avrState) {
   }
   treble = treble | abs(avrState.treble);
 
-  Wire.write(bass | treble);
+  mcuRegs[MCU_REG_EQ] = bass | treble;
+}
+
+// пересчитываются только группы регистров, чьи поля поменялись
+void syncMCU(uint8_t changed, const stateStruct &s) {
+  if (changed & MCU_VOL_FIELDS) mcuVolumeRegs(s);
+  if (changed & MCU_EQ_FIELDS) mcuEqReg(s);
+  rampWrite(mcuRegs, s.volume);
+}
 
-  Wire.endTransmission();
-  return avrState;
-}
\ No newline at end of file
+void setMCUState(const stateStruct &avrState) {
+  mcuVolumeRegs(avrState);
+  // Stereo    00 | Bypass              00  |   0000
+  // Lch Mono  01 | Tone                01  |   0000
+  // Rch Mono  10 | Tone & Surround Hi  10  |   0000
+  //              | Tone & Surround Low 11  |   0000
+  mcuRegs[MCU_REG_MODE] = B00010000;
+  mcuEqReg(avrState);
+  rampWrite(mcuRegs, avrState.volume);
+}
@@ -0,0 +1,229 @@
+#include "mcu.h"
+#include <util/atomic.h>
+
+// коды состояния TWSR
+#define TW_START       0x08
+#define TW_REP_START   0x10
+#define TW_MT_SLA_ACK  0x18
+#define TW_MT_SLA_NACK 0x20
+#define TW_MT_DATA_ACK 0x28
+#define TW_MT_DATA_NACK 0x30
+#define TW_MT_ARB_LOST 0x38
+#define TW_BUS_ERROR   0x00
+
+#define TWCR_IDLE  (_BV(TWEN))
+#define TWCR_START (_BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA))
+#define TWCR_NEXT  (_BV(TWINT) | _BV(TWEN) | _BV(TWIE))
+#define TWCR_STOP  (_BV(TWINT) | _BV(TWEN) | _BV(TWSTO))
+
+#define SDA_PIN A4
+#define SCL_PIN A5
+
+static byte wanted[MCU_REGS];     // желаемое состояние регистров
+static byte shadow[MCU_REGS];     // что уже записано в MCU
+static uint8_t shadowValid = 0;   // биты регистров, чьё значение в MCU известно
+static volatile bool pending = false;
+
+static byte txBuf[MCU_REGS + 1];  // субадрес + данные
+static uint8_t txLen;
+static volatile uint8_t txPos;
+static volatile bool busy = false;
+static volatile bool retryLater = false;
+static volatile bool retrySlow = false; // MCU_RETRIES неудач подряд, повтор через MCU_SLOW_RETRY_MS
+static volatile uint8_t failures = 0;   // неудач подряд
+static unsigned long startMs;
+static unsigned long errorMs;
+
+static volatile mcuStatsStruct stats;
+
+// маска регистров, отличающихся от теневой копии
+static uint8_t dirtyMask() {
+  uint8_t m = 0;
+  for (uint8_t i = 0; i < MCU_REGS; i++) {
+    if (!(shadowValid & _BV(i)) || wanted[i] != shadow[i]) m |= _BV(i);
+  }
+  return m;
+}
+
+// собрать ближайшую посылку и выставить START, вызывать с запрещёнными прерываниями
+static void startNext() {
+  uint8_t m = dirtyMask();
+  pending = false;
+  if (!m) return;
+
+  uint8_t first = 0;
+  while (!(m & _BV(first))) first++;
+  uint8_t last = first;
+  uint8_t gap = 0;
+  for (uint8_t i = first + 1; i < MCU_REGS; i++) {
+    if (m & _BV(i)) {
+      last = i;
+      gap = 0;
+    } else if (++gap > MCU_MERGE_GAP) {
+      break;
+    }
+  }
+
+  txLen = 0;
+  txBuf[txLen++] = first; // субадрес, дальше автоинкремент
+  for (uint8_t i = first; i <= last; i++) txBuf[txLen++] = wanted[i];
+  txPos = 0;
+  busy = true;
+  startMs = millis();
+  TWCR = TWCR_START;
+}
+
+// новый START только после того, как аппаратно закончится STOP прошлой посылки
+static bool canStart() {
+  return !busy && !retryLater && !(TWCR & _BV(TWSTO));
+}
+
+static void fail() {
+  busy = false;
+  stats.errors++;
+  if (!retrySlow && ++failures >= MCU_RETRIES) {
+    // MCU не отвечает (например, ещё включается): состояние не бросаем,
+    // а повторяем редко, и эти повторы не держат mcuBusy() и сон
+    retrySlow = true;
+    stats.gaveUp++;
+  }
+  // повторим позже из mcuTick, чтобы не забивать шину при отсутствии MCU
+  retryLater = true;
+  errorMs = millis();
+}
+
+static void finish() {
+  TWCR = TWCR_STOP;
+  busy = false;
+  failures = 0;
+  retrySlow = false;
+  stats.done++;
+  for (uint8_t i = 1; i < txLen; i++) {
+    uint8_t r = txBuf[0] + i - 1;
+    shadow[r] = txBuf[i];
+    shadowValid |= _BV(r);
+  }
+  // остальное отправит mcuTick, когда STOP закончится
+  if (dirtyMask()) pending = true;
+}
+
+void mcuInit() {
+  // подтяжки SDA/SCL, как в Wire.begin()
+  digitalWrite(SDA_PIN, HIGH);
+  digitalWrite(SCL_PIN, HIGH);
+  TWSR = 0; // делитель 1
+  TWBR = ((F_CPU / MCU_I2C_HZ) - 16) / 2;
+  TWCR = TWCR_IDLE;
+}
+
+void mcuWrite(const byte *regs) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (pending) stats.merged++;
+    memcpy(wanted, regs, MCU_REGS);
+    pending = true;
+    if (retrySlow) {
+      // новое состояние: снова MCU_RETRIES быстрых попыток
+      retrySlow = false;
+      retryLater = false;
+      failures = 0;
+    }
+    if (canStart()) startNext();
+  }
+}
+
+// восстановление зависшей шины: 9 импульсов SCL и STOP вручную
+static void busRecover() {
+  TWCR = 0;
+  pinMode(SDA_PIN, INPUT_PULLUP);
+  pinMode(SCL_PIN, OUTPUT);
+  for (uint8_t i = 0; i < 9; i++) {
+    digitalWrite(SCL_PIN, LOW);
+    delayMicroseconds(5);
+    digitalWrite(SCL_PIN, HIGH);
+    delayMicroseconds(5);
+  }
+  pinMode(SDA_PIN, OUTPUT);
+  digitalWrite(SDA_PIN, LOW);
+  delayMicroseconds(5);
+  digitalWrite(SDA_PIN, HIGH);
+  pinMode(SDA_PIN, INPUT_PULLUP);
+  pinMode(SCL_PIN, INPUT_PULLUP);
+  mcuInit();
+}
+
+void mcuTick() {
+  if (!busy) {
+    if (retryLater) {
+      if (millis() - errorMs < (retrySlow ? MCU_SLOW_RETRY_MS : MCU_TIMEOUT_MS)) return;
+      retryLater = false;
+    } else if (!pending) {
+      return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (canStart()) startNext();
+    }
+    return;
+  }
+  if (millis() - startMs < MCU_TIMEOUT_MS) return;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    stats.timeouts++;
+    // что успело записаться в MCU неизвестно, эти регистры перепишем
+    for (uint8_t i = 1; i < txLen; i++) shadowValid &= ~_BV(txBuf[0] + i - 1);
+  }
+  // busy остаётся до конца восстановления: mcuWrite() из прерывания рампы
+  // только запомнит состояние и не запустит TWI посреди ручных импульсов
+  busRecover();
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    busy = false;
+    startNext();
+  }
+}
+
+bool mcuBusy() {
+  return busy || pending || (retryLater && !retrySlow);
+}
+
+mcuStatsStruct mcuGetStats() {
+  mcuStatsStruct s;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    s.done = stats.done;
+    s.errors = stats.errors;
+    s.timeouts = stats.timeouts;
+    s.merged = stats.merged;
+    s.gaveUp = stats.gaveUp;
+    s.bytes = stats.bytes;
+  }
+  return s;
+}
+
+ISR(TWI_vect) {
+  switch (TWSR & 0xF8) {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = MCU_ADR << 1; // SLA+W
+      TWCR = TWCR_NEXT;
+      stats.bytes++;
+      break;
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (txPos < txLen) {
+        TWDR = txBuf[txPos++];
+        TWCR = TWCR_NEXT;
+        stats.bytes++;
+      } else {
+        finish();
+      }
+      break;
+    case TW_MT_ARB_LOST:
+      TWCR = TWCR_IDLE;
+      fail();
+      break;
+    case TW_MT_SLA_NACK:
+    case TW_MT_DATA_NACK:
+    case TW_BUS_ERROR:
+    default:
+      TWCR = TWCR_STOP;
+      fail();
+      break;
+  }
+}
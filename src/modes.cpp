@@ -0,0 +1,81 @@
+#include "modes.h"
+#include <avr/pgmspace.h>
+#include "state.h"
+#include "keymap.h"
+#include "volcurve.h"
+#include "display.h"
+
+constexpr char inputNames[] PROGMEM = "AUPC";
+
+// строка = режим энкодера, порядок строк - порядок перебора кликом
+constexpr modeStruct modes[] PROGMEM = {
+  // поле          min              max             шаг флаги                  имена       кнопки
+  {STATE_VOLUME,  0,               MAX_VOLUME,     1,  0,                     NULL,       KEY_VOL_UP,   KEY_VOL_DOWN},
+  {STATE_BASS,    -STATE_TONE_MAX, STATE_TONE_MAX, 1,  0,                     NULL,       KEY_BASS_UP,  KEY_BASS_DOWN},
+  {STATE_TREBLE,  -STATE_TONE_MAX, STATE_TONE_MAX, 1,  0,                     NULL,       KEY_TREB_UP,  KEY_TREB_DOWN},
+  {STATE_INPUT,   AUX,             PC,             1,  MODE_WRAP | MODE_ONCE, inputNames, KEY_INPUT_CH, KEY_UNDEFINED},
+};
+
+static_assert(sizeof(modes) / sizeof(modes[0]) == MODE_COUNT, "MODE_COUNT must match the modes table");
+
+#define MODE_NONE 0xFF
+
+// кнопка -> номер строки << 1 | направление вниз, строится при компиляции
+typedef struct {
+  uint8_t mode[KEY_COUNT];
+} keyModeStruct;
+
+constexpr keyModeStruct keyModeBuild() {
+  keyModeStruct t{};
+  for (uint8_t k = 0; k < KEY_COUNT; k++) t.mode[k] = MODE_NONE;
+  for (uint8_t i = 0; i < MODE_COUNT; i++) {
+    if (modes[i].keyUp != KEY_UNDEFINED) t.mode[modes[i].keyUp] = i << 1;
+    if (modes[i].keyDown != KEY_UNDEFINED) t.mode[modes[i].keyDown] = (i << 1) | 1;
+  }
+  return t;
+}
+
+constexpr keyModeStruct keyMode PROGMEM = keyModeBuild();
+
+static void apply(uint8_t mode, int delta) {
+  modeStruct m;
+  memcpy_P(&m, &modes[mode], sizeof(m));
+  int v = stateGetField(m.field);
+  if (m.flags & MODE_WRAP) {
+    int range = m.max - m.min + 1;
+    int step = delta > 0 ? m.step : range - m.step;
+    v = m.min + (v - m.min + step) % range;
+  } else {
+    v = constrain(v + delta * m.step, m.min, m.max);
+  }
+  stateSetField(m.field, v);
+}
+
+void modeTurn(uint8_t mode, int delta) {
+  if (mode < MODE_COUNT && delta) apply(mode, delta);
+}
+
+bool modeKey(uint8_t key, int steps, bool repeat) {
+  if (key >= KEY_COUNT) return false;
+  uint8_t k = pgm_read_byte(&keyMode.mode[key]);
+  if (k == MODE_NONE) return false;
+  uint8_t mode = k >> 1;
+  if (repeat && (pgm_read_byte(&modes[mode].flags) & MODE_ONCE)) return true;
+  apply(mode, k & 1 ? -steps : steps);
+  return true;
+}
+
+void modeShow(uint8_t field) {
+  for (uint8_t i = 0; i < MODE_COUNT; i++) {
+    if (pgm_read_byte(&modes[i].field) != field) continue;
+    int v = stateGetField(field);
+    PGM_P names = (PGM_P) pgm_read_ptr(&modes[i].names);
+    if (names) {
+      displayText_P(names + 2 * (v - (int8_t) pgm_read_byte(&modes[i].min)));
+    } else {
+      displayNumber(v);
+    }
+    return;
+  }
+  displayNumber(stateGetField(field));
+}
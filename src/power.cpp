@@ -0,0 +1,61 @@
+#include "power.h"
+#include "display.h"
+#include <avr/sleep.h>
+
+// кнопка энкодера A1 - PC1 (PCINT9), ИК 2 - PD2 (PCINT18), RX 0 - PD0 (PCINT16).
+// Повороты (PCINT10, PCINT11) будят через PCINT1_vect энкодера, он включён всегда.
+#define WAKE_MASK_C (_BV(PCINT9))
+#define WAKE_MASK_D (_BV(PCINT16) | _BV(PCINT18))
+
+static unsigned long activityMs;
+static unsigned long userMs;      // последнее действие пользователя, сон его не сдвигает
+static powerStatsStruct stats;
+
+void powerInit() {
+  PCMSK2 |= WAKE_MASK_D;
+  activityMs = userMs = millis();
+}
+
+void powerActivity() {
+  activityMs = userMs = millis();
+}
+
+unsigned long powerIdleMs() {
+  return millis() - userMs;
+}
+
+void powerTick(bool canSleep) {
+  if (!canSleep) {
+    activityMs = millis();
+    return;
+  }
+  if (millis() - activityMs < POWER_IDLE_MS) return;
+
+  Serial.flush(); // UART в power-save стоит, дописываем последний байт
+  displayOff();
+  stats.sleeps++;
+  set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+  cli();
+  byte pcicr = PCICR;
+  PCMSK1 |= WAKE_MASK_C;
+  PCIFR = _BV(PCIF2);
+  PCICR |= _BV(PCIE1) | _BV(PCIE2);
+  sleep_enable();
+  sei();  // следующая инструкция выполнится до прерывания, сон не пропустим
+  sleep_cpu();
+  sleep_disable();
+  cli();
+  PCICR = pcicr;
+  PCMSK1 &= ~WAKE_MASK_C;
+  sei();
+  stats.wakeups++; // таймеры стоят, будит только изменение уровня
+  displayOn();
+  activityMs = millis(); // даём время принять пакет, который нас разбудил
+}
+
+powerStatsStruct powerGetStats() {
+  return stats;
+}
+
+// пробуждение от ИК или RX, сами данные разберут их обработчики
+EMPTY_INTERRUPT(PCINT2_vect);
@@ -0,0 +1,76 @@
+#include "profiler.h"
+#include "protocol.h"
+
+#ifdef PROFILER
+
+typedef struct {
+  uint16_t min;
+  uint16_t max;
+  uint16_t hist[PROF_BUCKETS];
+} profStageStruct;
+
+#define PROF_DATA_LEN (2 + PROF_STAGES * sizeof(profStageStruct))
+
+static profStageStruct prof[PROF_STAGES];
+
+// отправка кадра по частям, пока в буфере UART есть место
+static int16_t txPos = -1;
+static uint8_t txSum;
+
+static void profReset() {
+  memset(prof, 0, sizeof(prof));
+  for (uint8_t i = 0; i < PROF_STAGES; i++) prof[i].min = 0xFFFF;
+}
+
+void profRecord(uint8_t stage, uint16_t ticks) {
+  static bool ready = false;
+  if (!ready) {
+    profReset();
+    ready = true;
+  }
+  // пока кадр уходит, статистика заморожена, чтобы он был одним срезом
+  if (txPos >= 0) return;
+  profStageStruct &s = prof[stage];
+  if (ticks < s.min) s.min = ticks;
+  if (ticks > s.max) s.max = ticks;
+  uint8_t b = 0;
+  for (uint16_t t = ticks >> 4; t && b < PROF_BUCKETS - 1; t >>= 1) b++;
+  if (s.hist[b] != 0xFFFF) s.hist[b]++;
+}
+
+// кадр длиннее буфера UART, поэтому идёт мимо protoSend() по частям
+static byte frameByte(uint16_t i) {
+  if (i == 0) return PROTO_START;
+  if (i == 1) return PROF_DATA_LEN + 1;
+  if (i == 2) return PROTO_PROF;
+  if (i == 3) return PROF_STAGES;
+  if (i == 4) return PROF_BUCKETS;
+  return ((const byte *) prof)[i - 5];
+}
+
+void profDump() {
+  if (txPos >= 0) return;
+  txPos = 0;
+  txSum = 0;
+}
+
+bool profBusy() {
+  return txPos >= 0;
+}
+
+void profTick() {
+  if (txPos < 0) return;
+  while (Serial.availableForWrite() > 0) {
+    if (txPos == PROF_DATA_LEN + 3) {
+      Serial.write(txSum);
+      txPos = -1;
+      profReset();
+      return;
+    }
+    byte b = frameByte(txPos++);
+    txSum += b;
+    Serial.write(b);
+  }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "protocol.h"
+#include "profiler.h"
+
+#define RX_START 0
+#define RX_LEN   1
+#define RX_DATA  2
+#define RX_SUM   3
+
+static protoHandler handler = NULL;
+static protoStatsStruct stats;
+
+static uint8_t rxState = RX_START;
+static uint8_t rxLen;
+static uint8_t rxPos;
+static uint8_t rxSum;
+static byte rxBuf[PROTO_MAX_DATA + 1]; // команда + данные
+
+void protoBegin(protoHandler h) {
+  handler = h;
+  Serial.begin(PROTO_BAUD);
+}
+
+void protoTick() {
+  // команда разбирается, только когда для ответа на неё есть место: пока
+  // уходит кадр профилировщика или буфер занят, команды ждут в буфере приёма
+  while (Serial.available() && protoRoom(PROTO_MAX_REPLY)) {
+    byte b = Serial.read();
+    switch (rxState) {
+      case RX_START:
+        if (b == PROTO_START) {
+          rxSum = b;
+          rxState = RX_LEN;
+        }
+        break;
+      case RX_LEN:
+        if (b == 0 || b > sizeof(rxBuf)) {
+          stats.badFrames++;
+          rxState = RX_START;
+          break;
+        }
+        rxLen = b;
+        rxPos = 0;
+        rxSum += b;
+        rxState = RX_DATA;
+        break;
+      case RX_DATA:
+        rxBuf[rxPos++] = b;
+        rxSum += b;
+        if (rxPos == rxLen) rxState = RX_SUM;
+        break;
+      case RX_SUM:
+        rxState = RX_START;
+        if (b != rxSum) {
+          stats.badFrames++;
+          break;
+        }
+        stats.frames++;
+        if (handler) handler(rxBuf[0], rxBuf + 1, rxLen - 1);
+        break;
+    }
+  }
+}
+
+bool protoRoom(uint8_t len) {
+  return !PROF_BUSY() && Serial.availableForWrite() >= len + 4;
+}
+
+bool protoSend(uint8_t cmd, const byte *data, uint8_t len) {
+  if (!protoRoom(len)) {
+    stats.txDropped++;
+    return false;
+  }
+  byte sum = PROTO_START + (len + 1) + cmd;
+  Serial.write(PROTO_START);
+  Serial.write(len + 1);
+  Serial.write(cmd);
+  for (uint8_t i = 0; i < len; i++) {
+    Serial.write(data[i]);
+    sum += data[i];
+  }
+  Serial.write(sum);
+  return true;
+}
+
+protoStatsStruct protoGetStats() {
+  return stats;
+}
@@ -0,0 +1,94 @@
+#include "ramp.h"
+#include "volcurve.h"
+#include <util/atomic.h>
+
+#define RAMP_IDLE 0
+#define RAMP_DOWN 1
+#define RAMP_UP   2
+
+static byte target[MCU_REGS];   // что хочет приложение
+static byte out[MCU_REGS];      // что отдано в mcuWrite
+static uint8_t targetVol;       // шаг громкости для target
+static uint8_t outVol;          // шаг громкости для out, шаги идут по кривой
+static bool outValid = false;
+static volatile uint8_t phase = RAMP_IDLE;
+
+static void timerStart() {
+  timebaseInit();
+  OCR1B = TCNT1 + RAMP_STEP_TICKS;
+  TIFR1 = _BV(OCF1B);
+  TIMSK1 |= _BV(OCIE1B);
+}
+
+static void timerStop() {
+  TIMSK1 &= ~_BV(OCIE1B);
+}
+
+// громкость 0 или вход отключён: щелчка не будет, поднимать и опускать нечего
+static bool silent(const byte *regs, uint8_t vol) {
+  return vol == 0 || regs[MCU_REG_INPUT] == MCU_INPUT_MUTE;
+}
+
+static void outWrite() {
+  out[MCU_REG_VOL_L] = volToReg(outVol);
+  out[MCU_REG_VOL_R] = out[MCU_REG_VOL_L];
+  mcuWrite(out);
+}
+
+void rampWrite(const byte *regs, int volume) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    memcpy(target, regs, MCU_REGS);
+    targetVol = constrain(volume, 0, MAX_VOLUME);
+    bool direct = phase == RAMP_IDLE && (!outValid || target[MCU_REG_INPUT] == out[MCU_REG_INPUT] ||
+                                         (silent(out, outVol) && silent(target, targetVol)));
+    if (direct) {
+      outValid = true;
+      memcpy(out, target, MCU_REGS);
+      outVol = targetVol;
+      mcuWrite(out);
+    } else if (target[MCU_REG_INPUT] != out[MCU_REG_INPUT]) {
+      if (phase == RAMP_IDLE) timerStart();
+      phase = RAMP_DOWN;
+    }
+    // во время плавного перехода громкость догонит цель в прерывании
+  }
+}
+
+bool rampActive() {
+  return phase != RAMP_IDLE;
+}
+
+ISR(TIMER1_COMPB_vect) {
+  OCR1B += RAMP_STEP_TICKS;
+
+  if (phase == RAMP_DOWN) {
+    if (!silent(out, outVol) && outVol > 1) {
+      outVol--;
+    } else {
+      // тишина, можно переключать вход
+      out[MCU_REG_INPUT] = target[MCU_REG_INPUT];
+      if (outVol > 1) outVol = 1; // вход был отключён, подъём с самого тихого шага
+      if (silent(target, targetVol)) outVol = targetVol;
+      phase = RAMP_UP;
+    }
+  } else if (silent(target, targetVol)) {
+    outVol = targetVol;
+  } else if (outVol < targetVol) {
+    outVol++;
+  } else if (outVol > targetVol) {
+    outVol--;
+  }
+  if (phase == RAMP_UP && outVol == targetVol) {
+    phase = RAMP_IDLE;
+    timerStop();
+  }
+  out[MCU_REG_MODE] = target[MCU_REG_MODE];
+  out[MCU_REG_EQ] = target[MCU_REG_EQ];
+  outWrite();
+
+  // вход поменяли ещё раз, пока поднимали громкость
+  if (phase != RAMP_DOWN && target[MCU_REG_INPUT] != out[MCU_REG_INPUT]) {
+    if (phase == RAMP_IDLE) timerStart();
+    phase = RAMP_DOWN;
+  }
+}
@@ -0,0 +1,112 @@
+#include "state.h"
+#include "volcurve.h"
+
+typedef struct {
+  uint8_t mask;
+  stateHandler handler;
+} subscriberStruct;
+
+static stateStruct state;
+static uint8_t dirty = 0;
+static subscriberStruct subscribers[STATE_SUBSCRIBERS];
+static uint8_t subscriberCount = 0;
+
+const stateStruct &stateGet() {
+  return state;
+}
+
+void stateSetVolume(int volume) {
+  volume = constrain(volume, 0, MAX_VOLUME);
+  if (state.volume == volume) return;
+  state.volume = volume;
+  dirty |= STATE_F_VOLUME;
+}
+
+void stateSetBass(int bass) {
+  bass = constrain(bass, -STATE_TONE_MAX, STATE_TONE_MAX);
+  if (state.bass == bass) return;
+  state.bass = bass;
+  dirty |= STATE_F_BASS;
+}
+
+void stateSetTreble(int treble) {
+  treble = constrain(treble, -STATE_TONE_MAX, STATE_TONE_MAX);
+  if (state.treble == treble) return;
+  state.treble = treble;
+  dirty |= STATE_F_TREBLE;
+}
+
+void stateSetInput(INPUTS input) {
+  if (state.inputCh == input) return;
+  state.inputCh = input;
+  dirty |= STATE_F_INPUT;
+}
+
+void stateSetMute(bool mute) {
+  if (state.isMute == mute) return;
+  state.isMute = mute;
+  dirty |= STATE_F_MUTE;
+}
+
+void stateSet(const stateStruct &s) {
+  stateSetVolume(s.volume);
+  stateSetBass(s.bass);
+  stateSetTreble(s.treble);
+  stateSetInput(s.inputCh);
+  stateSetMute(s.isMute);
+}
+
+int stateGetField(uint8_t field) {
+  switch (field) {
+    case STATE_VOLUME: return state.volume;
+    case STATE_BASS:   return state.bass;
+    case STATE_TREBLE: return state.treble;
+    case STATE_INPUT:  return state.inputCh == PC ? 1 : 0;
+    case STATE_MUTE:   return state.isMute;
+  }
+  return 0;
+}
+
+void stateSetField(uint8_t field, int value) {
+  switch (field) {
+    case STATE_VOLUME: stateSetVolume(value); break;
+    case STATE_BASS:   stateSetBass(value); break;
+    case STATE_TREBLE: stateSetTreble(value); break;
+    case STATE_INPUT:  stateSetInput(value ? PC : AUX); break;
+    case STATE_MUTE:   stateSetMute(value); break;
+  }
+}
+
+bool stateSubscribe(uint8_t mask, stateHandler handler) {
+  if (subscriberCount >= STATE_SUBSCRIBERS) return false;
+  subscribers[subscriberCount].mask = mask;
+  subscribers[subscriberCount].handler = handler;
+  subscriberCount++;
+  return true;
+}
+
+void stateTick() {
+  if (!dirty) return;
+  // подписчик может сам поменять состояние, это уйдёт следующим проходом
+  uint8_t changed = dirty;
+  dirty = 0;
+  for (uint8_t i = 0; i < subscriberCount; i++) {
+    uint8_t m = changed & subscribers[i].mask;
+    if (m) subscribers[i].handler(m, state);
+  }
+}
+
+void statePack(const stateStruct &s, byte *data) {
+  data[0] = s.volume;
+  data[1] = s.bass;
+  data[2] = s.treble;
+  data[3] = (s.inputCh == PC ? 1 : 0) | (s.isMute ? 2 : 0);
+}
+
+void stateUnpack(const byte *data, stateStruct *s) {
+  s->volume = constrain(data[0], 0, MAX_VOLUME);
+  s->bass = constrain((int8_t) data[1], -STATE_TONE_MAX, STATE_TONE_MAX);
+  s->treble = constrain((int8_t) data[2], -STATE_TONE_MAX, STATE_TONE_MAX);
+  s->inputCh = (data[3] & 1) ? PC : AUX;
+  s->isMute = data[3] & 2;
+}
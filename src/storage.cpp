@@ -0,0 +1,114 @@
+#include "storage.h"
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+
+typedef struct {
+  uint8_t seq;                    // номер записи, растёт по кругу
+  byte data[STORAGE_DATA_LEN];
+  uint8_t crc;                    // пишется последним: оборванная запись не пройдёт проверку
+} recordStruct;
+
+static recordStruct eeRing[STORAGE_SLOTS] EEMEM;
+
+static recordStruct saved;        // то, что лежит в EEPROM
+static uint8_t slot = STORAGE_SLOTS - 1;
+static byte pendingData[STORAGE_DATA_LEN];
+static bool pendingValid = false;
+static unsigned long changeMs;
+
+// фоновая запись
+static recordStruct txRecord;
+static uint16_t txAddr;
+static volatile uint8_t txPos;
+static volatile bool busy = false;
+
+static uint8_t crc8(const byte *p, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    crc ^= *p++;
+    for (uint8_t i = 0; i < 8; i++) crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+static bool readSlot(uint8_t i, recordStruct *r) {
+  eeprom_read_block(r, &eeRing[i], sizeof(recordStruct));
+  return r->crc == crc8((const byte *) r, sizeof(recordStruct) - 1);
+}
+
+bool storageLoad(byte *data) {
+  // последняя запись - целая, за которой в кольце нет записи со следующим номером
+  recordStruct r, next;
+  bool found = false;
+  bool nextValid = readSlot(0, &next);
+  for (uint8_t i = 0; i < STORAGE_SLOTS; i++) {
+    r = next;
+    bool valid = nextValid;
+    nextValid = readSlot((i + 1) % STORAGE_SLOTS, &next);
+    if (!valid) continue;
+    if (nextValid && next.seq == (uint8_t)(r.seq + 1)) continue;
+    saved = r;
+    slot = i;
+    found = true;
+    break;
+  }
+  if (!found) return false;
+  memcpy(data, saved.data, STORAGE_DATA_LEN);
+  memcpy(pendingData, saved.data, STORAGE_DATA_LEN);
+  return true;
+}
+
+static void startWrite() {
+  slot = (slot + 1) % STORAGE_SLOTS;
+  txRecord.seq = saved.seq + 1;
+  memcpy(txRecord.data, pendingData, STORAGE_DATA_LEN);
+  txRecord.crc = crc8((const byte *) &txRecord, sizeof(recordStruct) - 1);
+  saved = txRecord;
+  txAddr = (uintptr_t) &eeRing[slot];
+  txPos = 0;
+  busy = true;
+  EECR |= _BV(EERIE);
+}
+
+void storageSet(const byte *data) {
+  if (!memcmp(data, pendingData, STORAGE_DATA_LEN)) return;
+  memcpy(pendingData, data, STORAGE_DATA_LEN);
+  pendingValid = true;
+  changeMs = millis();
+}
+
+void storageTick() {
+  if (!pendingValid || busy) return;
+  if (millis() - changeMs < STORAGE_DELAY_MS) return;
+  pendingValid = false;
+  if (!memcmp(pendingData, saved.data, STORAGE_DATA_LEN)) return; // вернули как было
+  startWrite();
+}
+
+void storageWait() {
+  while (busy) yield(); // в модели (env:native) ожидание двигает время
+}
+
+bool storageBusy() {
+  return busy;
+}
+
+bool storagePending() {
+  return pendingValid;
+}
+
+ISR(EE_READY_vect) {
+  while (txPos < sizeof(recordStruct)) {
+    uint16_t addr = txAddr + txPos;
+    byte b = ((const byte *) &txRecord)[txPos++];
+    EEAR = addr;
+    EECR |= _BV(EERE);
+    if (EEDR == b) continue; // байт уже такой, не тратим ресурс
+    EEDR = b;
+    EECR |= _BV(EEMPE);
+    EECR |= _BV(EEPE);
+    return;
+  }
+  EECR &= ~_BV(EERIE);
+  busy = false;
+}
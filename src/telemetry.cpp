@@ -0,0 +1,37 @@
+#include "telemetry.h"
+#include "protocol.h"
+
+static_assert((TELE_RING & (TELE_RING - 1)) == 0, "TELE_RING must be a power of two");
+
+static teleRecord ring[TELE_RING];
+static uint8_t head = 0; // следующая свободная запись
+static uint8_t tail = 0; // следующая на отправку
+static uint16_t dropped = 0;
+
+void telemetryPush(uint8_t type, int8_t protocol, uint32_t code) {
+  if ((uint8_t)(head - tail) >= TELE_RING) {
+    dropped++;
+    return;
+  }
+  teleRecord &r = ring[head & (TELE_RING - 1)];
+  r.type = type;
+  r.protocol = protocol;
+  r.code = code;
+  r.ms = millis();
+  head++;
+}
+
+void telemetryTick() {
+  while (head != tail && protoRoom(sizeof(teleRecord))) {
+    protoSend(PROTO_EVENT, (const byte *) &ring[tail & (TELE_RING - 1)], sizeof(teleRecord));
+    tail++;
+  }
+}
+
+bool telemetryIdle() {
+  return head == tail;
+}
+
+uint16_t telemetryDropped() {
+  return dropped;
+}
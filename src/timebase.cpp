@@ -0,0 +1,10 @@
+#include "timebase.h"
+
+void timebaseInit() {
+  static bool started = false;
+  if (started) return;
+  started = true;
+  // normal mode, делитель 8
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11);
+}
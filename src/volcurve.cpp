@@ -0,0 +1,61 @@
+#include "volcurve.h"
+
+static_assert(MAX_VOLUME > 1 && MAX_VOLUME < 255, "MAX_VOLUME out of range");
+
+typedef struct {
+  byte v[MAX_VOLUME + 1];
+} volTableStruct;
+
+// 96 - 1.6 * v в целых числах
+constexpr volTableStruct volLinear() {
+  volTableStruct t{};
+  t.v[0] = VOL_ATT_MUTE;
+  for (uint8_t v = 1; v <= MAX_VOLUME; v++) {
+    t.v[v] = (uint16_t)VOL_ATT_MAX * (MAX_VOLUME - v) / MAX_VOLUME;
+  }
+  return t;
+}
+
+// точки кривой равномерно раскладываются на шаги 1..MAX_VOLUME,
+// промежуточные шаги линейно интерполируются
+template <uint8_t N>
+constexpr volTableStruct volFromPoints(const byte (&p)[N]) {
+  static_assert(N > 1, "curve needs at least two points");
+  volTableStruct t{};
+  t.v[0] = VOL_ATT_MUTE;
+  for (uint8_t v = 1; v <= MAX_VOLUME; v++) {
+    uint16_t num = (uint16_t)(v - 1) * (N - 1);
+    uint8_t i = num / (MAX_VOLUME - 1);
+    uint8_t r = num % (MAX_VOLUME - 1);
+    if (r) t.v[v] = ((uint16_t)p[i] * (MAX_VOLUME - 1 - r) + (uint16_t)p[i + 1] * r) / (MAX_VOLUME - 1);
+    else t.v[v] = p[i];
+  }
+  return t;
+}
+
+#if VOL_CURVE == VOL_CURVE_LINEAR
+constexpr volTableStruct volTable PROGMEM = volLinear();
+
+#elif VOL_CURVE == VOL_CURVE_ODS
+// столбец N из vol.ods, шаги 1..40
+constexpr byte volPoints[] = {
+  B01001110, B01001100, B01001010, B01001000, B01000110, B01000100, B01000010, B01000000,
+  B00111110, B00111100, B00111010, B00111000, B00110110, B00110100, B00110010, B00110000,
+  B00101110, B00101100, B00101010, B00101000, B00100110, B00100100, B00100010, B00100000,
+  B00011110, B00011100, B00011010, B00011000, B00010110, B00010100, B00010010, B00010000,
+  B00001110, B00001100, B00001010, B00001000, B00000110, B00000100, B00000010, B00000000,
+};
+constexpr volTableStruct volTable PROGMEM = volFromPoints(volPoints);
+
+#elif VOL_CURVE == VOL_CURVE_CUSTOM
+constexpr byte volPoints[] = {VOL_CURVE_POINTS};
+constexpr volTableStruct volTable PROGMEM = volFromPoints(volPoints);
+
+#else
+#error "unknown VOL_CURVE"
+#endif
+
+byte volToReg(int volume) {
+  volume = constrain(volume, 0, MAX_VOLUME);
+  return pgm_read_byte(&volTable.v[volume]);
+}
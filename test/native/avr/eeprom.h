@@ -0,0 +1,20 @@
+#pragma once
+// Переменные EEMEM лежат в отдельной секции, их адрес - смещение от её
+// начала. Сами данные хранит модель EEPROM в sim.cpp, функции ниже, как в
+// avr-libc, ждут окончания предыдущей записи и запускают свою.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define EEMEM __attribute__((section("sim_eeprom")))
+
+uint8_t eeprom_read_byte(const uint8_t *p);
+uint16_t eeprom_read_word(const uint16_t *p);
+uint32_t eeprom_read_dword(const uint32_t *p);
+void eeprom_read_block(void *dst, const void *src, size_t n);
+void eeprom_write_byte(uint8_t *p, uint8_t value);
+void eeprom_update_byte(uint8_t *p, uint8_t value);
+void eeprom_update_block(const void *src, void *dst, size_t n);
+void eeprom_write_block(const void *src, void *dst, size_t n);
+bool eeprom_is_ready();
+#define eeprom_busy_wait() do { } while (!eeprom_is_ready())
@@ -0,0 +1,16 @@
+#pragma once
+// Флаг I в SREG ведёт модель: cli()/sei() меняют его, прерывания
+// вызываются из sim.cpp только при разрешённом флаге и вне другого прерывания.
+
+#include <avr/io.h>
+
+void simCli();
+void simSei();
+
+#define cli() simCli()
+#define sei() simSei()
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR(vector, ...) extern "C" void vector(void)
+#define EMPTY_INTERRUPT(vector) extern "C" void vector(void) {}
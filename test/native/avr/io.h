@@ -0,0 +1,196 @@
+#pragma once
+// Регистры ATmega168 для модели периферии (sim.cpp). Регистр - объект:
+// чтение и запись идут через обработчики модели там, где это важно
+// (TWI, EEPROM, таймеры, флаги, SREG), остальные просто хранят значение.
+
+#include <stdint.h>
+
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+
+struct SimReg8 {
+  uint8_t v;
+  uint8_t (*rd)();        // NULL - вернуть v
+  void (*wr)(uint8_t x);  // NULL - записать в v
+
+  operator uint8_t() const { return rd ? rd() : v; }
+  SimReg8 &operator=(uint8_t x) {
+    if (wr) wr(x);
+    else v = x;
+    return *this;
+  }
+  SimReg8 &operator=(const SimReg8 &r) { return *this = (uint8_t) r; }
+  SimReg8 &operator|=(uint8_t x) { return *this = (uint8_t) (*this | x); }
+  SimReg8 &operator&=(uint8_t x) { return *this = (uint8_t) (*this & x); }
+  SimReg8 &operator^=(uint8_t x) { return *this = (uint8_t) (*this ^ x); }
+};
+
+struct SimReg16 {
+  uint16_t v;
+  uint16_t (*rd)();
+  void (*wr)(uint16_t x);
+
+  operator uint16_t() const { return rd ? rd() : v; }
+  SimReg16 &operator=(uint16_t x) {
+    if (wr) wr(x);
+    else v = x;
+    return *this;
+  }
+  SimReg16 &operator=(const SimReg16 &r) { return *this = (uint16_t) r; }
+  SimReg16 &operator+=(uint16_t x) { return *this = (uint16_t) (*this + x); }
+  SimReg16 &operator-=(uint16_t x) { return *this = (uint16_t) (*this - x); }
+  SimReg16 &operator|=(uint16_t x) { return *this = (uint16_t) (*this | x); }
+  SimReg16 &operator&=(uint16_t x) { return *this = (uint16_t) (*this & x); }
+};
+
+#define SIM_REG8(n) extern SimReg8 n;
+#define SIM_REG16(n) extern SimReg16 n;
+
+SIM_REG8(PINB) SIM_REG8(DDRB) SIM_REG8(PORTB)
+SIM_REG8(PINC) SIM_REG8(DDRC) SIM_REG8(PORTC)
+SIM_REG8(PIND) SIM_REG8(DDRD) SIM_REG8(PORTD)
+SIM_REG8(SREG) SIM_REG8(SMCR) SIM_REG8(MCUCR) SIM_REG8(PRR) SIM_REG8(GTCCR)
+SIM_REG8(TCCR0A) SIM_REG8(TCCR0B) SIM_REG8(TIMSK0) SIM_REG8(TIFR0)
+SIM_REG8(TCCR1A) SIM_REG8(TCCR1B) SIM_REG8(TCCR1C) SIM_REG8(TIMSK1) SIM_REG8(TIFR1)
+SIM_REG16(TCNT1) SIM_REG16(OCR1A) SIM_REG16(OCR1B) SIM_REG16(ICR1)
+SIM_REG8(TCCR2A) SIM_REG8(TCCR2B) SIM_REG8(TCNT2) SIM_REG8(OCR2A) SIM_REG8(OCR2B)
+SIM_REG8(TIMSK2) SIM_REG8(TIFR2) SIM_REG8(ASSR)
+SIM_REG8(TWBR) SIM_REG8(TWSR) SIM_REG8(TWAR) SIM_REG8(TWDR) SIM_REG8(TWCR)
+SIM_REG8(EECR) SIM_REG8(EEDR) SIM_REG16(EEAR)
+SIM_REG8(PCICR) SIM_REG8(PCIFR) SIM_REG8(PCMSK0) SIM_REG8(PCMSK1) SIM_REG8(PCMSK2)
+SIM_REG8(EICRA) SIM_REG8(EIMSK) SIM_REG8(EIFR)
+SIM_REG8(UCSR0A) SIM_REG8(UCSR0B) SIM_REG8(UCSR0C) SIM_REG8(UDR0)
+
+// биты портов
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define SREG_I 7
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+
+// Timer1
+#define WGM10 0
+#define WGM11 1
+#define COM1B0 4
+#define COM1B1 5
+#define COM1A0 6
+#define COM1A1 7
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define WGM13 4
+#define ICES1 6
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+
+// Timer2
+#define WGM20 0
+#define WGM21 1
+#define COM2B0 4
+#define COM2B1 5
+#define COM2A0 6
+#define COM2A1 7
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM22 3
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+#define TOV2 0
+#define OCF2A 1
+#define OCF2B 2
+
+// TWI
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+#define TWPS0 0
+#define TWPS1 1
+
+// EEPROM
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+#define E2END 511
+
+// внешние прерывания и PCINT
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define INT0 0
+#define INT1 1
+#define INTF0 0
+#define INTF1 1
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT3 3
+#define PCINT4 4
+#define PCINT5 5
+#define PCINT8 0
+#define PCINT9 1
+#define PCINT10 2
+#define PCINT11 3
+#define PCINT12 4
+#define PCINT13 5
+#define PCINT16 0
+#define PCINT17 1
+#define PCINT18 2
+#define PCINT19 3
+#define PCINT20 4
+#define PCINT21 5
+#define PCINT22 6
+#define PCINT23 7
+
+// векторы: обработчики ISR() - обычные функции, модель вызывает их сама
+#define INT0_vect sim_INT0_vect
+#define PCINT0_vect sim_PCINT0_vect
+#define PCINT1_vect sim_PCINT1_vect
+#define PCINT2_vect sim_PCINT2_vect
+#define TIMER2_COMPA_vect sim_TIMER2_COMPA_vect
+#define TIMER1_COMPA_vect sim_TIMER1_COMPA_vect
+#define TIMER1_COMPB_vect sim_TIMER1_COMPB_vect
+#define EE_READY_vect sim_EE_READY_vect
+#define TWI_vect sim_TWI_vect
@@ -0,0 +1,26 @@
+#pragma once
+// на ПК flash и RAM - одна память
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+
+// байт, прочитанных через pgm_read_*: на МК каждый - инструкция LPM
+extern uint32_t simFlashBytes;
+
+#define SIM_PGM_READ(type, addr) (simFlashBytes += sizeof(type), *(const type *) (addr))
+#define pgm_read_byte(addr) SIM_PGM_READ(uint8_t, addr)
+#define pgm_read_word(addr) SIM_PGM_READ(uint16_t, addr)
+#define pgm_read_dword(addr) SIM_PGM_READ(uint32_t, addr)
+#define pgm_read_ptr(addr) (simFlashBytes += 2, *(void *const *) (addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word_near(addr) pgm_read_word(addr)
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strcmp_P strcmp
@@ -0,0 +1,17 @@
+#pragma once
+// sleep_cpu() в модели ждёт разрешённого прерывания от выводов,
+// таймеры и millis() во сне стоят, как в power-save
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN _BV(SM1)
+#define SLEEP_MODE_PWR_SAVE (_BV(SM0) | _BV(SM1))
+
+#define set_sleep_mode(mode) (SMCR = (SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode))
+#define sleep_enable() (SMCR |= _BV(SE))
+#define sleep_disable() (SMCR &= ~_BV(SE))
+
+void sleep_cpu();
+#define sleep_mode() do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
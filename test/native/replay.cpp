@@ -0,0 +1,262 @@
+#include "replay.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <ctype.h>
+
+void setup();
+void loop();
+
+static bool booted = false;
+
+static char *logBuf = NULL;
+static uint32_t logLen, logCap;
+static bool logEcho = false;
+
+static uint8_t uartBuf[1024];
+static uint16_t uartLen;
+
+static uint64_t at(uint32_t ms) {
+  return SIM_CYCLES_MS(ms);
+}
+
+static void logLine(const char *line) {
+  if (logEcho) puts(line);
+  uint32_t n = strlen(line);
+  if (logLen + n + 2 > logCap) {
+    logCap = (logLen + n + 2) * 2;
+    logBuf = (char *) realloc(logBuf, logCap);
+  }
+  memcpy(logBuf + logLen, line, n);
+  logLen += n;
+  logBuf[logLen++] = '\n';
+  logBuf[logLen] = 0;
+}
+
+// ушедшее в UART копится для replayUart(), в лог его пишет модель
+static void uartCollect() {
+  uartLen += simSerialTake(uartBuf + uartLen, sizeof(uartBuf) - uartLen);
+}
+
+void replayBoot() {
+  if (booted) return;
+  booted = true;
+  setup();
+  uartCollect();
+}
+
+void replayRun(uint32_t ms) {
+  replayBoot();
+  // во сне sleep_cpu() ждёт пробуждения не дольше, чем до конца прогона
+  simSetHorizon(at(ms));
+  while (simNow() < at(ms)) {
+    loop();
+    uartCollect();
+    uint64_t next = simNow() + SIM_CYCLES_US(REPLAY_LOOP_US);
+    simRunUntil(next < at(ms) ? next : at(ms));
+  }
+  uartCollect();
+}
+
+void replayRunFor(uint32_t ms) {
+  replayRun(replayNowMs() + ms);
+}
+
+uint32_t replayNowMs() {
+  return simNow() / SIM_CYCLES_MS(1);
+}
+
+// ---------------------------------------------------------------- ИК
+
+// импульс - LOW на выходе приёмника
+static uint64_t irPulses(uint64_t t, const uint16_t *us, uint8_t len) {
+  for (uint8_t i = 0; i < len; i++) {
+    simPinAt(t, REPLAY_PIN_IR, i & 1);
+    t += SIM_CYCLES_US(us[i]);
+  }
+  simPinAt(t, REPLAY_PIN_IR, 1);
+  return t;
+}
+
+void replayIrNec(uint32_t ms, uint32_t code) {
+  uint16_t us[2 + 64 + 1];
+  uint8_t n = 0;
+  us[n++] = 9000;
+  us[n++] = 4500;
+  for (int8_t i = 31; i >= 0; i--) {
+    us[n++] = 560;
+    us[n++] = (code >> i) & 1 ? 1690 : 560;
+  }
+  us[n++] = 560;
+  irPulses(at(ms), us, n);
+}
+
+void replayIrRepeat(uint32_t ms) {
+  static const uint16_t us[] = {9000, 2250, 560};
+  irPulses(at(ms), us, 3);
+}
+
+void replayIrRaw(uint32_t ms, const uint16_t *us, uint8_t len) {
+  irPulses(at(ms), us, len);
+}
+
+// ---------------------------------------------------------------- энкодер
+
+// фазы A3 | A2 << 1, по часовой: 3 -> 1 -> 0 -> 2 -> 3 (EB_STEP4_LOW)
+void replayEncoder(uint32_t ms, int16_t steps, uint16_t intervalMs) {
+  static const uint8_t cw[] = {1, 0, 2, 3};
+  static const uint8_t ccw[] = {2, 0, 1, 3};
+  const uint8_t *seq = steps > 0 ? cw : ccw;
+  uint16_t n = steps > 0 ? steps : -steps;
+  uint64_t t = at(ms);
+  for (uint16_t s = 0; s < n; s++) {
+    for (uint8_t i = 0; i < 4; i++) {
+      uint64_t e = t + SIM_CYCLES_MS(REPLAY_ENC_EDGE_MS) * i;
+      simPinAt(e, REPLAY_PIN_ENC_A, seq[i] & 1);
+      simPinAt(e, REPLAY_PIN_ENC_B, seq[i] & 2);
+    }
+    t += SIM_CYCLES_MS(intervalMs);
+  }
+}
+
+void replayButton(uint32_t ms, bool down) {
+  simPinAt(at(ms), REPLAY_PIN_BTN, !down);
+}
+
+void replayClick(uint32_t ms) {
+  replayButton(ms, true);
+  replayButton(ms + REPLAY_CLICK_MS, false);
+}
+
+// ---------------------------------------------------------------- UART
+
+void replaySerial(uint32_t ms, const uint8_t *data, uint8_t len) {
+  simSerialAt(at(ms), data, len);
+}
+
+void replayCommand(uint32_t ms, uint8_t cmd, const uint8_t *data, uint8_t len) {
+  uint8_t f[PROTO_MAX_DATA + 4];
+  uint8_t n = 0;
+  f[n++] = PROTO_START;
+  f[n++] = len + 1;
+  f[n++] = cmd;
+  for (uint8_t i = 0; i < len; i++) f[n++] = data[i];
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < n; i++) sum += f[i];
+  f[n++] = sum;
+  replaySerial(ms, f, n);
+}
+
+// ---------------------------------------------------------------- запись входов
+
+static bool nextWord(const char **p, char *w, uint8_t max) {
+  while (**p == ' ' || **p == '\t') (*p)++;
+  uint8_t n = 0;
+  while (**p && !isspace((unsigned char) **p) && n < max - 1) w[n++] = *(*p)++;
+  w[n] = 0;
+  return n > 0;
+}
+
+uint32_t replayParse(const char *text) {
+  uint32_t end = 0;
+  uint16_t lineNo = 0;
+  const char *p = text;
+  while (*p) {
+    const char *eol = strchr(p, '\n');
+    if (!eol) eol = p + strlen(p);
+    char line[512];
+    size_t len = eol - p < (long) sizeof(line) - 1 ? eol - p : sizeof(line) - 1;
+    memcpy(line, p, len);
+    line[len] = 0;
+    p = *eol ? eol + 1 : eol;
+    lineNo++;
+    char *hash = strchr(line, '#');
+    if (hash) *hash = 0;
+
+    const char *q = line;
+    char w[16], kind[16];
+    if (!nextWord(&q, w, sizeof(w))) continue;
+    uint32_t ms = strtoul(w, NULL, 10);
+    if (!nextWord(&q, kind, sizeof(kind))) goto bad;
+    if (ms > end) end = ms;
+
+    if (!strcmp(kind, "end")) {
+      return ms;
+    } else if (!strcmp(kind, "ir")) {
+      if (!nextWord(&q, w, sizeof(w))) goto bad;
+      if (!strcmp(w, "nec")) {
+        if (!nextWord(&q, w, sizeof(w))) goto bad;
+        replayIrNec(ms, strtoul(w, NULL, 16));
+      } else if (!strcmp(w, "repeat")) {
+        replayIrRepeat(ms);
+      } else if (!strcmp(w, "raw")) {
+        uint16_t us[RAW_BUFFER_LENGTH];
+        uint8_t n = 0;
+        while (n < RAW_BUFFER_LENGTH && nextWord(&q, w, sizeof(w))) us[n++] = strtoul(w, NULL, 10);
+        replayIrRaw(ms, us, n);
+      } else {
+        goto bad;
+      }
+    } else if (!strcmp(kind, "enc")) {
+      if (!nextWord(&q, w, sizeof(w))) goto bad;
+      bool cw = !strcmp(w, "cw");
+      if (!cw && strcmp(w, "ccw")) goto bad;
+      if (!nextWord(&q, w, sizeof(w))) goto bad;
+      int16_t n = strtol(w, NULL, 10);
+      uint16_t interval = nextWord(&q, w, sizeof(w)) ? strtoul(w, NULL, 10) : 20;
+      replayEncoder(ms, cw ? n : -n, interval);
+    } else if (!strcmp(kind, "btn")) {
+      if (!nextWord(&q, w, sizeof(w))) goto bad;
+      if (!strcmp(w, "down")) replayButton(ms, true);
+      else if (!strcmp(w, "up")) replayButton(ms, false);
+      else if (!strcmp(w, "click")) replayClick(ms);
+      else goto bad;
+    } else if (!strcmp(kind, "serial")) {
+      uint8_t data[64];
+      uint8_t n = 0;
+      while (n < sizeof(data) && nextWord(&q, w, sizeof(w))) data[n++] = strtoul(w, NULL, 16);
+      replaySerial(ms, data, n);
+    } else {
+      goto bad;
+    }
+    continue;
+  bad:
+    fprintf(stderr, "replay: line %u: %s\n", lineNo, line);
+    return 0;
+  }
+  return end;
+}
+
+// ---------------------------------------------------------------- лог
+
+void replayLogStart(bool echo) {
+  logEcho = echo;
+  simSetLog(logLine);
+}
+
+const char *replayLog() {
+  return logBuf ? logBuf : "";
+}
+
+bool replayLogHas(const char *s) {
+  return strstr(replayLog(), s) != NULL;
+}
+
+uint16_t replayLogCount(const char *s) {
+  uint16_t n = 0;
+  for (const char *p = replayLog(); (p = strstr(p, s)) != NULL; p += strlen(s)) n++;
+  return n;
+}
+
+void replayLogClear() {
+  logLen = 0;
+  if (logBuf) logBuf[0] = 0;
+}
+
+uint16_t replayUart(uint8_t *buf, uint16_t max) {
+  uartCollect();
+  uint16_t n = uartLen < max ? uartLen : max;
+  memcpy(buf, uartBuf, n);
+  memmove(uartBuf, uartBuf + n, uartLen - n);
+  uartLen -= n;
+  return n;
+}
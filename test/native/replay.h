@@ -0,0 +1,59 @@
+#pragma once
+// Прогон прошивки на модели (sim.h) по записанным входам.
+//
+// Входы ставятся в очередь модели на абсолютное время (мс от сброса),
+// replayRun() крутит loop() с шагом REPLAY_LOOP_US до нужного момента.
+// Лог модели (I2C, кадры индикации) и байты, ушедшие в UART ("uart A5 ..."),
+// собираются в буфер, его проверяют тесты и печатает replay_main.
+//
+// Формат записи входов, строка на событие, '#' - комментарий:
+//   <мс> ir nec 00FF02FD        кадр NEC, код как в decode_results.value
+//   <мс> ir repeat              повтор NEC
+//   <мс> ir raw 9000 4500 560   длительности, мкс, начиная с импульса
+//   <мс> enc cw|ccw <n> [мс]    n щелчков с интервалом (по умолчанию 20 мс)
+//   <мс> btn down|up|click      кнопка энкодера, click - 100 мс нажатия
+//   <мс> serial A5 01 01 A7     байты в RX
+//   <мс> end                    прогнать до этого момента
+
+#include "sim.h"
+
+#define REPLAY_LOOP_US 100      // время одного прохода loop() между вызовами
+#define REPLAY_ENC_EDGE_MS 1    // между фронтами фаз внутри щелчка
+#define REPLAY_CLICK_MS 100
+
+#define REPLAY_PIN_IR  2
+#define REPLAY_PIN_BTN A1
+#define REPLAY_PIN_ENC_A A3
+#define REPLAY_PIN_ENC_B A2
+
+// setup() прошивки, один раз за процесс (статические переменные не сбросить)
+void replayBoot();
+// крутить loop() до момента ms
+void replayRun(uint32_t ms);
+void replayRunFor(uint32_t ms);
+uint32_t replayNowMs();
+
+void replayIrNec(uint32_t ms, uint32_t code);
+void replayIrRepeat(uint32_t ms);
+void replayIrRaw(uint32_t ms, const uint16_t *us, uint8_t len);
+// steps > 0 - по часовой стрелке
+void replayEncoder(uint32_t ms, int16_t steps, uint16_t intervalMs = 20);
+void replayButton(uint32_t ms, bool down);
+void replayClick(uint32_t ms);
+void replaySerial(uint32_t ms, const uint8_t *data, uint8_t len);
+// кадр протокола с суммой, см. protocol.h
+void replayCommand(uint32_t ms, uint8_t cmd, const uint8_t *data = NULL, uint8_t len = 0);
+
+// разобрать запись входов и поставить её в очередь, вернёт момент "end"
+// (или последнего события), 0 и сообщение в stderr при ошибке
+uint32_t replayParse(const char *text);
+
+// лог: копить в буфер и, если echo, печатать в stdout
+void replayLogStart(bool echo);
+const char *replayLog();
+bool replayLogHas(const char *s);
+// сколько раз s встречается в логе
+uint16_t replayLogCount(const char *s);
+void replayLogClear();
+// байты UART, ушедшие с прошлого вызова (в логе они - строки "uart ...")
+uint16_t replayUart(uint8_t *buf, uint16_t max);
@@ -0,0 +1,36 @@
+// Прогон записи входов: replay <файл> [--quiet]
+// Печатает лог модели, по нему сравнивают с эталоном (test/traces/*.log).
+// В сборке тестов (pio test) не участвует, там свой main.
+#ifndef PIO_UNIT_TESTING
+
+#include "replay.h"
+#include <stdio.h>
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s trace.txt [--quiet]\n", argv[0]);
+    return 2;
+  }
+  FILE *f = fopen(argv[1], "rb");
+  if (!f) {
+    perror(argv[1]);
+    return 2;
+  }
+  static char text[64 * 1024];
+  size_t n = fread(text, 1, sizeof(text) - 1, f);
+  fclose(f);
+  text[n] = 0;
+
+  bool quiet = argc > 2 && !strcmp(argv[2], "--quiet");
+  replayLogStart(!quiet);
+  replayBoot();
+  uint32_t end = replayParse(text);
+  if (!end) return 1;
+  replayRun(end);
+  simDisplayStruct d = simDisplay();
+  printf("end: %u ms, frames %u, i2c %u/%u bytes, sleep %s\n", (unsigned) end, (unsigned) d.frames,
+         (unsigned) simI2cTransactions(), (unsigned) simI2cBytes(), simSleeping() ? "yes" : "no");
+  return 0;
+}
+
+#endif
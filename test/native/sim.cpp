@@ -0,0 +1,1051 @@
+#include "sim.h"
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#define NEVER UINT64_MAX
+
+// обработчики из прошивки, отсутствующие остаются NULL
+extern "C" {
+void INT0_vect(void) __attribute__((weak));
+void PCINT0_vect(void) __attribute__((weak));
+void PCINT1_vect(void) __attribute__((weak));
+void PCINT2_vect(void) __attribute__((weak));
+void TIMER2_COMPA_vect(void) __attribute__((weak));
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER1_COMPB_vect(void) __attribute__((weak));
+void EE_READY_vect(void) __attribute__((weak));
+void TWI_vect(void) __attribute__((weak));
+}
+
+// начало секции EEMEM, её создаёт компоновщик
+extern "C" char __start_sim_eeprom[];
+
+byte displayGlyph(char c);
+
+// ---------------------------------------------------------------- время
+
+static uint64_t now;        // стенные часы, такты
+static uint64_t awake;      // часы таймеров, во сне стоят
+static uint64_t horizon = NEVER;
+static bool sleeping = false;
+static uint8_t isrDepth = 0;
+static uint32_t isrCount[SIM_VECTORS];
+static simLogHandler logHandler = NULL;
+
+static void runUntil(uint64_t t);
+
+// ---------------------------------------------------------------- регистры
+
+static uint8_t pinsRead(uint8_t first, uint8_t n);
+static uint8_t twcrRead();
+static void twcrWrite(uint8_t x);
+static uint8_t eecrRead();
+static void eecrWrite(uint8_t x);
+static void eearWrite(uint16_t x);
+static uint16_t tcnt1Read();
+static void tcnt1Write(uint16_t x);
+static void tccr1bWrite(uint8_t x);
+static void tccr2bWrite(uint8_t x);
+
+static uint8_t pinbRead() { return pinsRead(8, 6); }
+static uint8_t pincRead() { return pinsRead(14, 6); }
+static uint8_t pindRead() { return pinsRead(0, 8); }
+static void portbWrite(uint8_t x);
+static void portdWrite(uint8_t x);
+static void tifr1Write(uint8_t x);
+static void tifr2Write(uint8_t x);
+static void pcifrWrite(uint8_t x);
+static void eifrWrite(uint8_t x);
+
+SimReg8 PINB = {0, pinbRead, NULL};
+SimReg8 DDRB = {0, NULL, NULL};
+SimReg8 PORTB = {0, NULL, portbWrite};
+SimReg8 PINC = {0, pincRead, NULL};
+SimReg8 DDRC = {0, NULL, NULL};
+SimReg8 PORTC = {0, NULL, NULL};
+SimReg8 PIND = {0, pindRead, NULL};
+SimReg8 DDRD = {0, NULL, NULL};
+SimReg8 PORTD = {0, NULL, portdWrite};
+SimReg8 SREG = {0, NULL, NULL};
+SimReg8 SMCR = {0, NULL, NULL};
+SimReg8 MCUCR = {0, NULL, NULL};
+SimReg8 PRR = {0, NULL, NULL};
+SimReg8 GTCCR = {0, NULL, NULL};
+SimReg8 TCCR0A = {0, NULL, NULL};
+SimReg8 TCCR0B = {0, NULL, NULL};
+SimReg8 TIMSK0 = {0, NULL, NULL};
+SimReg8 TIFR0 = {0, NULL, NULL};
+SimReg8 TCCR1A = {0, NULL, NULL};
+SimReg8 TCCR1B = {0, NULL, tccr1bWrite};
+SimReg8 TCCR1C = {0, NULL, NULL};
+SimReg8 TIMSK1 = {0, NULL, NULL};
+SimReg8 TIFR1 = {0, NULL, tifr1Write};
+SimReg16 TCNT1 = {0, tcnt1Read, tcnt1Write};
+SimReg16 OCR1A = {0, NULL, NULL};
+SimReg16 OCR1B = {0, NULL, NULL};
+SimReg16 ICR1 = {0, NULL, NULL};
+SimReg8 TCCR2A = {0, NULL, NULL};
+SimReg8 TCCR2B = {0, NULL, tccr2bWrite};
+SimReg8 TCNT2 = {0, NULL, NULL};
+SimReg8 OCR2A = {0, NULL, NULL};
+SimReg8 OCR2B = {0, NULL, NULL};
+SimReg8 TIMSK2 = {0, NULL, NULL};
+SimReg8 TIFR2 = {0, NULL, tifr2Write};
+SimReg8 ASSR = {0, NULL, NULL};
+SimReg8 TWBR = {0, NULL, NULL};
+SimReg8 TWSR = {0xF8, NULL, NULL};
+SimReg8 TWAR = {0, NULL, NULL};
+SimReg8 TWDR = {0xFF, NULL, NULL};
+SimReg8 TWCR = {0, twcrRead, twcrWrite};
+SimReg8 EECR = {0, eecrRead, eecrWrite};
+SimReg8 EEDR = {0, NULL, NULL};
+SimReg16 EEAR = {0, NULL, eearWrite};
+SimReg8 PCICR = {0, NULL, NULL};
+SimReg8 PCIFR = {0, NULL, pcifrWrite};
+SimReg8 PCMSK0 = {0, NULL, NULL};
+SimReg8 PCMSK1 = {0, NULL, NULL};
+SimReg8 PCMSK2 = {0, NULL, NULL};
+SimReg8 EICRA = {0, NULL, NULL};
+SimReg8 EIMSK = {0, NULL, NULL};
+SimReg8 EIFR = {0, NULL, eifrWrite};
+SimReg8 UCSR0A = {0, NULL, NULL};
+SimReg8 UCSR0B = {0, NULL, NULL};
+SimReg8 UCSR0C = {0, NULL, NULL};
+SimReg8 UDR0 = {0, NULL, NULL};
+
+// флаги прерываний сбрасываются записью единицы
+static void tifr1Write(uint8_t x) { TIFR1.v &= ~x; }
+static void tifr2Write(uint8_t x) { TIFR2.v &= ~x; }
+static void pcifrWrite(uint8_t x) { PCIFR.v &= ~x; }
+static void eifrWrite(uint8_t x) { EIFR.v &= ~x; }
+
+void simCli() {
+  SREG.v &= ~_BV(SREG_I);
+}
+
+void simSei() {
+  SREG.v |= _BV(SREG_I);
+}
+
+// ---------------------------------------------------------------- таймеры
+
+static uint16_t prescaler(uint8_t cs, bool timer2) {
+  static const uint16_t t1[] = {0, 1, 8, 64, 256, 1024, 0, 0};
+  static const uint16_t t2[] = {0, 1, 8, 32, 64, 128, 256, 1024};
+  return timer2 ? t2[cs & 7] : t1[cs & 7];
+}
+
+static uint64_t t1Origin;       // awake, когда счёт был бы равен 0
+static uint16_t t1Stopped;      // значение остановленного счётчика
+static uint64_t t1LastA = NEVER, t1LastB = NEVER;  // номер такта последнего совпадения
+static uint64_t t2Origin;
+static uint64_t t2Last;
+
+static uint64_t t1Ticks() {
+  return (awake - t1Origin) / prescaler(TCCR1B.v, false);
+}
+
+static uint16_t tcnt1Read() {
+  if (!prescaler(TCCR1B.v, false)) return t1Stopped;
+  return (uint16_t) t1Ticks();
+}
+
+static void tcnt1Write(uint16_t x) {
+  uint16_t p = prescaler(TCCR1B.v, false);
+  t1Stopped = x;
+  if (p) t1Origin = awake - (uint64_t) x * p;
+  t1LastA = t1LastB = NEVER;
+}
+
+static void tccr1bWrite(uint8_t x) {
+  uint16_t count = tcnt1Read();
+  TCCR1B.v = x;
+  tcnt1Write(count);
+}
+
+static void tccr2bWrite(uint8_t x) {
+  TCCR2B.v = x;
+  t2Origin = awake;
+  t2Last = 0;
+}
+
+// момент (awake) ближайшего совпадения OCR1x после такта last
+static uint64_t t1Match(uint16_t ocr, uint64_t last) {
+  uint16_t p = prescaler(TCCR1B.v, false);
+  if (!p) return NEVER;
+  uint64_t c = t1Ticks();
+  uint32_t delta = (uint16_t) (ocr - (uint16_t) c);
+  if (delta == 0 && last == c) delta = 0x10000;
+  return t1Origin + (c + delta) * p;
+}
+
+static uint64_t t2Period() {
+  uint16_t p = prescaler(TCCR2B.v, true);
+  if (!p || !(TCCR2A.v & _BV(WGM21))) return 0;
+  return (uint64_t) (OCR2A.v + 1) * p;
+}
+
+// ---------------------------------------------------------------- выводы
+
+typedef struct {
+  uint64_t at;
+  uint8_t pin;                  // 0xFF - байт UART
+  uint8_t value;
+} inputStruct;
+
+static inputStruct *inputs = NULL;
+static uint32_t inputCount = 0;
+static uint32_t inputHead = 0;
+static uint32_t inputCap = 0;
+
+static bool level[SIM_PINS];    // уровень на входе
+static bool out[SIM_PINS];      // PORT для выхода
+static uint8_t mode[SIM_PINS];
+
+static void addInput(uint64_t at, uint8_t pin, uint8_t value) {
+  if (inputHead && inputHead == inputCount) inputHead = inputCount = 0;
+  if (inputCount == inputCap) {
+    inputCap = inputCap ? inputCap * 2 : 1024;
+    inputs = (inputStruct *) realloc(inputs, inputCap * sizeof(inputStruct));
+  }
+  // вставка с сохранением порядка, события почти всегда идут по времени
+  uint32_t i = inputCount++;
+  while (i > inputHead && inputs[i - 1].at > at) {
+    inputs[i] = inputs[i - 1];
+    i--;
+  }
+  inputs[i].at = at;
+  inputs[i].pin = pin;
+  inputs[i].value = value;
+}
+
+static uint8_t pinsRead(uint8_t first, uint8_t n) {
+  uint8_t v = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    bool b = mode[first + i] == OUTPUT ? out[first + i] : level[first + i];
+    if (b) v |= _BV(i);
+  }
+  return v;
+}
+
+static void pinChanged(uint8_t pin, bool was) {
+  if (pin < 8) {
+    if (PCMSK2.v & _BV(pin)) PCIFR.v |= _BV(PCIF2);
+  } else if (pin < 14) {
+    if (PCMSK0.v & _BV(pin - 8)) PCIFR.v |= _BV(PCIF0);
+  } else {
+    if (PCMSK1.v & _BV(pin - 14)) PCIFR.v |= _BV(PCIF1);
+  }
+  if (pin == 2) {
+    uint8_t isc = EICRA.v & (_BV(ISC01) | _BV(ISC00));
+    bool rise = !was && level[pin];
+    if (isc == _BV(ISC00) || (isc == _BV(ISC01) && !rise) || (isc == (_BV(ISC01) | _BV(ISC00)) && rise)) {
+      EIFR.v |= _BV(INTF0);
+    }
+  }
+}
+
+static void inputLevel(uint8_t pin, bool v) {
+  if (pin >= SIM_PINS || level[pin] == v) return;
+  bool was = level[pin];
+  level[pin] = v;
+  pinChanged(pin, was);
+}
+
+void pinMode(uint8_t pin, uint8_t m) {
+  if (pin < SIM_PINS) mode[pin] = m;
+}
+
+static uint8_t sclPulses = 0;
+static bool i2cHang = false;
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= SIM_PINS) return;
+  // busRecover дёргает SCL вручную, 9 импульсов отпускают зависшую шину
+  if (pin == A5 && mode[pin] == OUTPUT && !out[pin] && val && ++sclPulses >= 9 && i2cHang) {
+    i2cHang = false;
+    simLog("i2c bus released");
+  }
+  out[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= SIM_PINS) return LOW;
+  return mode[pin] == OUTPUT ? out[pin] : level[pin];
+}
+
+void simPinSet(uint8_t pin, bool v) {
+  inputLevel(pin, v);
+}
+
+void simPinAt(uint64_t cycles, uint8_t pin, bool v) {
+  addInput(cycles, pin, v);
+}
+
+bool simPinGet(uint8_t pin) {
+  return pin < SIM_PINS && level[pin];
+}
+
+uint32_t simPendingInputs() {
+  return inputCount - inputHead;
+}
+
+// ---------------------------------------------------------------- индикация
+
+// PB0 B, PB1 C, PB3 D, PB2 E, PD6 A, PD5 F, PD7 G; разряды PD3, PD4
+static simDisplayStruct disp;
+static int8_t dispLit = -1;       // горящий разряд
+static int8_t dispPeriod = -1;    // разряд текущего периода развёртки
+static uint8_t dispScan[2];       // сегменты за текущую пару периодов
+static uint8_t dispPrev[2];       // предыдущая пара
+static uint8_t dispSegNow;
+static uint64_t dispMark;
+
+static uint8_t dispSegments() {
+  uint8_t b = PORTB.v, d = PORTD.v, s = 0;
+  if (d & _BV(PD6)) s |= _BV(0);
+  if (b & _BV(PB0)) s |= _BV(1);
+  if (b & _BV(PB1)) s |= _BV(2);
+  if (b & _BV(PB3)) s |= _BV(3);
+  if (b & _BV(PB2)) s |= _BV(4);
+  if (d & _BV(PD5)) s |= _BV(5);
+  if (d & _BV(PD7)) s |= _BV(6);
+  return s;
+}
+
+static void dispObserve() {
+  if (dispLit >= 0 && dispSegNow) disp.onCycles[dispLit] += now - dispMark;
+  dispMark = now;
+
+  uint8_t g = PORTD.v & (_BV(PD3) | _BV(PD4));
+  dispLit = g == _BV(PD3) ? 0 : g == _BV(PD4) ? 1 : -1;
+  dispSegNow = dispSegments();
+  if (dispLit < 0) return;
+  if (dispLit != dispPeriod) {
+    // пара периодов закончилась: кадр засчитывается, если повторился дважды,
+    // так смена изображения между разрядами не даёт смешанного кадра
+    if (dispLit == 0 && dispPeriod == 1) {
+      if (dispScan[0] == dispPrev[0] && dispScan[1] == dispPrev[1]
+          && (dispScan[0] != disp.seg[0] || dispScan[1] != disp.seg[1] || !disp.frames)) {
+        disp.seg[0] = dispScan[0];
+        disp.seg[1] = dispScan[1];
+        disp.frames++;
+        simLog("disp %c%c", simGlyphChar(disp.seg[0]), simGlyphChar(disp.seg[1]));
+      }
+      dispPrev[0] = dispScan[0];
+      dispPrev[1] = dispScan[1];
+    }
+    dispPeriod = dispLit;
+    disp.scans[dispLit]++;
+  }
+  dispScan[dispLit] = dispSegNow;
+}
+
+static void portbWrite(uint8_t x) {
+  PORTB.v = x;
+  for (uint8_t i = 0; i < 6; i++) out[8 + i] = x & _BV(i);
+  dispObserve();
+}
+
+static void portdWrite(uint8_t x) {
+  PORTD.v = x;
+  for (uint8_t i = 0; i < 8; i++) out[i] = x & _BV(i);
+  dispObserve();
+}
+
+simDisplayStruct simDisplay() {
+  dispObserve();
+  return disp;
+}
+
+void simDisplayClear() {
+  uint8_t s0 = disp.seg[0], s1 = disp.seg[1];
+  uint32_t f = disp.frames;
+  memset(&disp, 0, sizeof(disp));
+  disp.seg[0] = s0;
+  disp.seg[1] = s1;
+  disp.frames = f;
+  dispMark = now;
+}
+
+char simGlyphChar(uint8_t seg) {
+  static const char order[] = " 0123456789-ABCDEFGHIJKLMNOPQRSTUVWXYZ_=?[]/\"'";
+  for (const char *c = order; *c; c++) {
+    if (displayGlyph(*c) == seg) return *c;
+  }
+  return '?';
+}
+
+// ---------------------------------------------------------------- TWI
+
+#define TWI_IDLE  0
+#define TWI_START 1
+#define TWI_BYTE  2
+
+typedef struct {
+  bool present;
+  uint8_t nackByte;
+  uint16_t nackCount;
+  uint8_t reg[256];
+} i2cDevStruct;
+
+static i2cDevStruct i2cDev[128];
+static uint8_t twiOp = TWI_IDLE;
+static uint64_t twiDoneAt = NEVER;    // awake
+static uint8_t twiResult;
+static bool twint = false;
+static uint64_t twiStopAt = NEVER;
+static bool twiOwned = false;
+static uint32_t i2cTransactions, i2cBytes;
+
+// текущая транзакция для лога
+static int16_t trAddr = -1;
+static uint8_t trData[32];
+static uint8_t trLen;
+static bool trNack;
+static uint8_t trSub;
+
+static uint64_t twiBitCycles() {
+  uint8_t ps = TWSR.v & 3;
+  return 16 + 2ULL * TWBR.v * (1 << (2 * ps));
+}
+
+static void twiLogTransaction() {
+  if (trAddr < 0) return;
+  char line[160];
+  int n = snprintf(line, sizeof(line), "i2c %02X:", trAddr);
+  for (uint8_t i = 0; i < trLen && n < (int) sizeof(line) - 8; i++) n += snprintf(line + n, sizeof(line) - n, " %02X", trData[i]);
+  if (trNack) snprintf(line + n, sizeof(line) - n, " NACK");
+  simLog("%s", line);
+  i2cTransactions++;
+  trAddr = -1;
+}
+
+static uint8_t twcrRead() {
+  uint8_t v = TWCR.v & ~(_BV(TWINT) | _BV(TWSTO));
+  if (twint) v |= _BV(TWINT);
+  if (twiStopAt != NEVER) v |= _BV(TWSTO);
+  return v;
+}
+
+static void twcrWrite(uint8_t x) {
+  TWCR.v = x & ~(_BV(TWINT) | _BV(TWSTO));
+  if (!(x & _BV(TWEN))) {
+    // модуль выключен: шина отпущена, всё брошено
+    twiLogTransaction();
+    twiOp = TWI_IDLE;
+    twiDoneAt = twiStopAt = NEVER;
+    twint = false;
+    twiOwned = false;
+    return;
+  }
+  if (!(x & _BV(TWINT))) return;  // только TWIE/TWEA
+  twint = false;
+  uint64_t bit = twiBitCycles();
+  if (x & _BV(TWSTO)) {
+    twiLogTransaction();
+    twiOwned = false;
+    twiStopAt = awake + bit;
+    twiOp = TWI_IDLE;
+    twiDoneAt = NEVER;
+    if (!(x & _BV(TWSTA))) return;
+  }
+  if (x & _BV(TWSTA)) {
+    twiLogTransaction();
+    twiOp = TWI_START;
+    twiResult = twiOwned ? 0x10 : 0x08;
+    uint64_t from = twiStopAt != NEVER ? twiStopAt : awake;
+    twiDoneAt = i2cHang ? NEVER : from + bit;
+    sclPulses = 0;
+    return;
+  }
+  // передача байта из TWDR
+  uint8_t b = TWDR.v;
+  i2cBytes++;
+  twiOp = TWI_BYTE;
+  twiDoneAt = awake + 9 * bit;
+  if (trAddr < 0) {
+    trAddr = b >> 1;
+    trLen = 0;
+    trNack = false;
+    i2cDevStruct &d = i2cDev[trAddr];
+    twiResult = d.present ? 0x18 : 0x20;
+    trNack = !d.present;
+    return;
+  }
+  i2cDevStruct &d = i2cDev[trAddr];
+  if (d.nackCount && trLen == d.nackByte) {
+    twiResult = 0x30;
+    trNack = true;
+    if (trLen < sizeof(trData)) trData[trLen++] = b;
+    return;
+  }
+  twiResult = 0x28;
+  if (trLen == 0) trSub = b;
+  else d.reg[trSub++] = b;
+  if (trLen < sizeof(trData)) trData[trLen++] = b;
+}
+
+static void twiDone() {
+  twiDoneAt = NEVER;
+  twiOp = TWI_IDLE;
+  if (twiResult == 0x08 || twiResult == 0x10) twiOwned = true;
+  TWSR.v = (TWSR.v & 3) | twiResult;
+  twint = true;
+}
+
+static void twiStopDone() {
+  twiStopAt = NEVER;
+  // NACK считается на транзакцию, после её окончания
+}
+
+void simI2cDevice(uint8_t addr, bool present) {
+  i2cDev[addr & 0x7F].present = present;
+}
+
+void simI2cNack(uint8_t addr, uint8_t n, uint16_t count) {
+  i2cDev[addr & 0x7F].nackByte = n;
+  i2cDev[addr & 0x7F].nackCount = count;
+}
+
+void simI2cHang(bool hang) {
+  i2cHang = hang;
+  sclPulses = 0;
+}
+
+uint32_t simI2cTransactions() {
+  return i2cTransactions;
+}
+
+uint32_t simI2cBytes() {
+  return i2cBytes;
+}
+
+uint8_t simI2cReg(uint8_t addr, uint8_t reg) {
+  return i2cDev[addr & 0x7F].reg[reg];
+}
+
+// ---------------------------------------------------------------- flash
+
+uint32_t simFlashBytes;
+
+// ---------------------------------------------------------------- EEPROM
+
+static uint8_t eeMem[SIM_EEPROM_SIZE];
+static uint32_t eeWrites[SIM_EEPROM_SIZE];
+static uint64_t eeDoneAt = NEVER;     // awake
+static uint16_t eeAddr;
+static uint8_t eeData;
+
+uint16_t simEepromAddr(const void *p) {
+  return (uint16_t) ((uintptr_t) p - (uintptr_t) __start_sim_eeprom);
+}
+
+// прошивка пишет в EEAR адрес переменной EEMEM, обрезанный до 16 бит
+static void eearWrite(uint16_t x) {
+  EEAR.v = (uint16_t) (x - (uint16_t) (uintptr_t) __start_sim_eeprom) % SIM_EEPROM_SIZE;
+}
+
+static uint8_t eecrRead() {
+  return (EECR.v & ~_BV(EEPE)) | (eeDoneAt != NEVER ? _BV(EEPE) : 0);
+}
+
+static void eeStart(uint16_t addr, uint8_t data) {
+  eeAddr = addr % SIM_EEPROM_SIZE;
+  eeData = data;
+  eeDoneAt = awake + SIM_CYCLES_US(SIM_EE_WRITE_US);
+}
+
+static void eecrWrite(uint8_t x) {
+  bool mpe = EECR.v & _BV(EEMPE);
+  EECR.v = x & ~(_BV(EERE) | _BV(EEPE));
+  if ((x & _BV(EERE)) && eeDoneAt == NEVER) EEDR.v = eeMem[EEAR.v];
+  if ((x & _BV(EEPE)) && mpe && eeDoneAt == NEVER) {
+    eeStart(EEAR.v, EEDR.v);
+    EECR.v &= ~_BV(EEMPE);
+  }
+}
+
+static void eeDone() {
+  eeMem[eeAddr] = eeData;
+  eeWrites[eeAddr]++;
+  simLog("eeprom %03X %02X", eeAddr, eeData);
+  eeDoneAt = NEVER;
+}
+
+bool eeprom_is_ready() {
+  return eeDoneAt == NEVER;
+}
+
+static void eeWait() {
+  while (eeDoneAt != NEVER) yield();
+}
+
+uint8_t eeprom_read_byte(const uint8_t *p) {
+  eeWait();
+  return eeMem[simEepromAddr(p) % SIM_EEPROM_SIZE];
+}
+
+uint16_t eeprom_read_word(const uint16_t *p) {
+  uint16_t v;
+  eeprom_read_block(&v, p, sizeof(v));
+  return v;
+}
+
+uint32_t eeprom_read_dword(const uint32_t *p) {
+  uint32_t v;
+  eeprom_read_block(&v, p, sizeof(v));
+  return v;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+  uint16_t a = simEepromAddr(src);
+  for (size_t i = 0; i < n; i++) ((uint8_t *) dst)[i] = eeprom_read_byte((const uint8_t *) __start_sim_eeprom + a + i);
+}
+
+void eeprom_write_byte(uint8_t *p, uint8_t value) {
+  eeWait();
+  eeStart(simEepromAddr(p), value);
+}
+
+void eeprom_update_byte(uint8_t *p, uint8_t value) {
+  if (eeprom_read_byte(p) != value) eeprom_write_byte(p, value);
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t n) {
+  for (size_t i = 0; i < n; i++) eeprom_update_byte((uint8_t *) dst + i, ((const uint8_t *) src)[i]);
+}
+
+void eeprom_write_block(const void *src, void *dst, size_t n) {
+  for (size_t i = 0; i < n; i++) eeprom_write_byte((uint8_t *) dst + i, ((const uint8_t *) src)[i]);
+}
+
+uint8_t *simEeprom() {
+  return eeMem;
+}
+
+uint32_t simEepromWrites(uint16_t addr) {
+  return eeWrites[addr % SIM_EEPROM_SIZE];
+}
+
+void simEepromPowerLoss() {
+  if (eeDoneAt == NEVER) return;
+  eeMem[eeAddr] = 0xFF;
+  eeDoneAt = NEVER;
+}
+
+// ---------------------------------------------------------------- UART
+
+HardwareSerial Serial;
+
+static uint64_t uartByte = SIM_CYCLES_US(87);   // 10 бит на 115200
+static uint8_t rxBuf[SIM_UART_RX_BUF];
+static uint8_t rxHead, rxTail;
+static uint8_t txBuf[SIM_UART_TX_BUF];
+static uint8_t txHead, txTail;
+static uint64_t txDoneAt = NEVER;     // awake, конец передачи байта txTail
+static uint8_t *line = NULL;          // ушедшее в линию
+static uint32_t lineLen, lineCap;
+static uint32_t uartLost;
+static uint8_t burst[128];            // байты подряд идущей передачи для лога
+static uint8_t burstLen;
+
+// передача без пауз - одна строка лога
+static void uartLogBurst() {
+  char text[4 + 3 * sizeof(burst) + 1] = "uart";
+  for (uint8_t i = 0; i < burstLen; i++) sprintf(text + 4 + 3 * i, " %02X", burst[i]);
+  simLog("%s", text);
+  burstLen = 0;
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+  uartByte = SIM_HZ * 10 / baud;
+}
+
+int HardwareSerial::available() {
+  return (uint8_t) (rxHead - rxTail);
+}
+
+int HardwareSerial::peek() {
+  if (rxHead == rxTail) return -1;
+  return rxBuf[rxTail % SIM_UART_RX_BUF];
+}
+
+int HardwareSerial::read() {
+  if (rxHead == rxTail) return -1;
+  return rxBuf[rxTail++ % SIM_UART_RX_BUF];
+}
+
+int HardwareSerial::availableForWrite() {
+  return SIM_UART_TX_BUF - 1 - (uint8_t) (txHead - txTail);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  // как в ядре: при полном буфере ждём места
+  while (availableForWrite() == 0) yield();
+  txBuf[txHead++ % SIM_UART_TX_BUF] = c;
+  if (txDoneAt == NEVER) txDoneAt = awake + uartByte;
+  return 1;
+}
+
+void HardwareSerial::flush() {
+  while (txHead != txTail) yield();
+}
+
+static void uartTxDone() {
+  if (lineLen == lineCap) {
+    lineCap = lineCap ? lineCap * 2 : 1024;
+    line = (uint8_t *) realloc(line, lineCap);
+  }
+  uint8_t b = txBuf[txTail++ % SIM_UART_TX_BUF];
+  line[lineLen++] = b;
+  burst[burstLen++] = b;
+  txDoneAt = txHead != txTail ? awake + uartByte : NEVER;
+  if (txDoneAt == NEVER || burstLen == sizeof(burst)) uartLogBurst();
+}
+
+static void uartRx(uint8_t b) {
+  if (sleeping || (uint8_t) (rxHead - rxTail) >= SIM_UART_RX_BUF) {
+    uartLost++;
+    return;
+  }
+  rxBuf[rxHead++ % SIM_UART_RX_BUF] = b;
+}
+
+void simSerialAt(uint64_t cycles, const uint8_t *data, uint16_t len) {
+  for (uint16_t i = 0; i < len; i++) {
+    uint64_t t = cycles + i * uartByte;
+    // старт-бит на RX будит МК через PCINT16
+    addInput(t, 0, 0);
+    addInput(t + uartByte / 10, 0, 1);
+    addInput(t + uartByte, 0xFF, data[i]);
+  }
+}
+
+uint16_t simSerialTake(uint8_t *buf, uint16_t max) {
+  uint16_t n = lineLen < max ? lineLen : max;
+  memcpy(buf, line, n);
+  memmove(line, line + n, lineLen - n);
+  lineLen -= n;
+  return n;
+}
+
+uint32_t simSerialLost() {
+  return uartLost;
+}
+
+// ---------------------------------------------------------------- Print
+
+size_t Print::write(const uint8_t *buf, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buf++);
+  return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char *s = &buf[sizeof(buf) - 1];
+  *s = 0;
+  if (base < 2) base = 10;
+  do {
+    uint8_t d = n % base;
+    n /= base;
+    *--s = d < 10 ? '0' + d : 'A' + d - 10;
+  } while (n);
+  return write(s);
+}
+
+size_t Print::print(const __FlashStringHelper *s) { return write((const char *) s); }
+size_t Print::print(const char *s) { return write(s); }
+size_t Print::print(char c) { return write((uint8_t) c); }
+size_t Print::print(unsigned char n, int base) { return printNumber(n, base); }
+size_t Print::print(unsigned int n, int base) { return printNumber(n, base); }
+size_t Print::print(unsigned long n, int base) { return printNumber(n, base); }
+size_t Print::print(int n, int base) { return print((long) n, base); }
+
+size_t Print::print(long n, int base) {
+  if (base == 10 && n < 0) return write('-') + printNumber(-n, 10);
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+// ---------------------------------------------------------------- ядро
+
+static bool vectorPending(uint8_t v) {
+  switch (v) {
+    case SIM_INT0: return (EIFR.v & _BV(INTF0)) && (EIMSK.v & _BV(INT0));
+    case SIM_PCINT0: return (PCIFR.v & _BV(PCIF0)) && (PCICR.v & _BV(PCIE0));
+    case SIM_PCINT1: return (PCIFR.v & _BV(PCIF1)) && (PCICR.v & _BV(PCIE1));
+    case SIM_PCINT2: return (PCIFR.v & _BV(PCIF2)) && (PCICR.v & _BV(PCIE2));
+    case SIM_TIMER2_COMPA: return (TIFR2.v & _BV(OCF2A)) && (TIMSK2.v & _BV(OCIE2A));
+    case SIM_TIMER1_COMPA: return (TIFR1.v & _BV(OCF1A)) && (TIMSK1.v & _BV(OCIE1A));
+    case SIM_TIMER1_COMPB: return (TIFR1.v & _BV(OCF1B)) && (TIMSK1.v & _BV(OCIE1B));
+    case SIM_EE_READY: return (EECR.v & _BV(EERIE)) && eeDoneAt == NEVER;
+    case SIM_TWI: return twint && (TWCR.v & _BV(TWIE)) && (TWCR.v & _BV(TWEN));
+  }
+  return false;
+}
+
+static void vectorCall(uint8_t v) {
+  static void (*const handlers[SIM_VECTORS])() = {
+    INT0_vect, PCINT0_vect, PCINT1_vect, PCINT2_vect, TIMER2_COMPA_vect,
+    TIMER1_COMPA_vect, TIMER1_COMPB_vect, EE_READY_vect, TWI_vect,
+  };
+  // флаг сбрасывается аппаратно при входе в прерывание
+  switch (v) {
+    case SIM_INT0: EIFR.v &= ~_BV(INTF0); break;
+    case SIM_PCINT0: PCIFR.v &= ~_BV(PCIF0); break;
+    case SIM_PCINT1: PCIFR.v &= ~_BV(PCIF1); break;
+    case SIM_PCINT2: PCIFR.v &= ~_BV(PCIF2); break;
+    case SIM_TIMER2_COMPA: TIFR2.v &= ~_BV(OCF2A); break;
+    case SIM_TIMER1_COMPA: TIFR1.v &= ~_BV(OCF1A); break;
+    case SIM_TIMER1_COMPB: TIFR1.v &= ~_BV(OCF1B); break;
+  }
+  isrCount[v]++;
+  if (!handlers[v]) {
+    fprintf(stderr, "sim: vector %u enabled without ISR\n", v);
+    abort();
+  }
+  isrDepth++;
+  simCli();
+  handlers[v]();
+  simSei();
+  isrDepth--;
+}
+
+// вызвать все ожидающие прерывания
+static void deliver() {
+  if (isrDepth) return;
+  uint32_t guard = 0;
+  while (SREG.v & _BV(SREG_I)) {
+    uint8_t v = 0;
+    while (v < SIM_VECTORS && !vectorPending(v)) v++;
+    if (v == SIM_VECTORS) return;
+    if (++guard > 100000) {
+      fprintf(stderr, "sim: vector %u never clears\n", v);
+      abort();
+    }
+    vectorCall(v);
+  }
+}
+
+static bool wakePending() {
+  for (uint8_t v = SIM_INT0; v <= SIM_PCINT2; v++) {
+    if (vectorPending(v)) return true;
+  }
+  return false;
+}
+
+// стенное время события, назначенного по часам таймеров
+static uint64_t fromAwake(uint64_t t) {
+  if (t == NEVER || sleeping) return NEVER;
+  return t <= awake ? now : now + (t - awake);
+}
+
+static uint64_t nextEvent() {
+  uint64_t t = inputHead < inputCount ? inputs[inputHead].at : NEVER;
+  uint64_t a = NEVER;
+  if (TIMSK1.v & _BV(OCIE1A)) a = min(a, t1Match(OCR1A.v, t1LastA));
+  if (TIMSK1.v & _BV(OCIE1B)) a = min(a, t1Match(OCR1B.v, t1LastB));
+  uint64_t p = t2Period();
+  if (p && (TIMSK2.v & _BV(OCIE2A))) a = min(a, t2Origin + ((awake - t2Origin) / p + 1) * p);
+  a = min(a, twiDoneAt);
+  a = min(a, twiStopAt);
+  a = min(a, eeDoneAt);
+  a = min(a, txDoneAt);
+  return min(t, fromAwake(a));
+}
+
+static void advance(uint64_t t) {
+  if (t <= now) return;
+  if (!sleeping) awake += t - now;
+  now = t;
+}
+
+static void processDue() {
+  while (inputHead < inputCount && inputs[inputHead].at <= now) {
+    inputStruct e = inputs[inputHead++];
+    if (e.pin == 0xFF) uartRx(e.value);
+    else inputLevel(e.pin, e.value);
+  }
+  if (sleeping) return;
+  if ((TIMSK1.v & _BV(OCIE1A)) && t1Match(OCR1A.v, t1LastA) <= awake) {
+    TIFR1.v |= _BV(OCF1A);
+    t1LastA = t1Ticks();
+  }
+  if ((TIMSK1.v & _BV(OCIE1B)) && t1Match(OCR1B.v, t1LastB) <= awake) {
+    TIFR1.v |= _BV(OCF1B);
+    t1LastB = t1Ticks();
+  }
+  uint64_t p = t2Period();
+  if (p && (TIMSK2.v & _BV(OCIE2A))) {
+    uint64_t k = (awake - t2Origin) / p;
+    if (k > t2Last) {
+      t2Last = k;
+      TIFR2.v |= _BV(OCF2A);
+    }
+  }
+  if (twiDoneAt <= awake) twiDone();
+  if (twiStopAt <= awake) twiStopDone();
+  if (eeDoneAt <= awake) eeDone();
+  if (txDoneAt <= awake) uartTxDone();
+}
+
+static void runUntil(uint64_t t) {
+  for (;;) {
+    deliver();
+    uint64_t n = nextEvent();
+    if (n > t) break;
+    advance(n);
+    processDue();
+  }
+  advance(t);
+  processDue();
+  deliver();
+}
+
+void simRunUntil(uint64_t cycles) {
+  runUntil(cycles);
+}
+
+void simRunUs(uint64_t us) {
+  runUntil(now + SIM_CYCLES_US(us));
+}
+
+uint64_t simNow() {
+  return now;
+}
+
+uint64_t simNowUs() {
+  return now / SIM_CYCLES_US(1);
+}
+
+bool simSleeping() {
+  return sleeping;
+}
+
+uint64_t simAwakeCycles() {
+  return awake;
+}
+
+void simSetHorizon(uint64_t cycles) {
+  horizon = cycles;
+}
+
+unsigned long millis() {
+  return awake / SIM_CYCLES_MS(1);
+}
+
+unsigned long micros() {
+  return awake / SIM_CYCLES_US(1);
+}
+
+void delay(unsigned long ms) {
+  runUntil(now + SIM_CYCLES_MS(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  runUntil(now + SIM_CYCLES_US(us));
+}
+
+void yield() {
+  uint64_t n = nextEvent();
+  uint64_t limit = now + SIM_CYCLES_MS(1);
+  runUntil(n > now && n < limit ? n : n <= now ? now : limit);
+}
+
+void sleep_cpu() {
+  if (!(SMCR.v & _BV(SE))) return;
+  simLog("sleep");
+  sleeping = true;
+  while (!wakePending()) {
+    uint64_t n = nextEvent();
+    if (n == NEVER || n > horizon) {
+      if (horizon != NEVER && horizon > now) advance(horizon);
+      break;
+    }
+    advance(n);
+    processDue();
+  }
+  // запуск кварца после пробуждения, таймеры ещё стоят
+  if (wakePending()) {
+    simLog("wake");
+    uint64_t t = now + SIM_WAKE_CYCLES;
+    while (inputHead < inputCount && inputs[inputHead].at <= t) {
+      advance(inputs[inputHead].at);
+      processDue();
+    }
+    advance(t);
+  }
+  sleeping = false;
+  deliver();
+}
+
+// ---------------------------------------------------------------- лог
+
+void simSetLog(simLogHandler h) {
+  logHandler = h;
+}
+
+void simLog(const char *fmt, ...) {
+  if (!logHandler) return;
+  char buf[200];
+  int n = snprintf(buf, sizeof(buf), "%9.3f ", (double) now / SIM_CYCLES_MS(1));
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf + n, sizeof(buf) - n, fmt, ap);
+  va_end(ap);
+  logHandler(buf);
+}
+
+uint32_t simIsrCount(uint8_t vector) {
+  return vector < SIM_VECTORS ? isrCount[vector] : 0;
+}
+
+void simReset() {
+  now = awake = 0;
+  horizon = NEVER;
+  sleeping = false;
+  memset(isrCount, 0, sizeof(isrCount));
+  inputHead = inputCount = 0;
+  for (uint8_t i = 0; i < SIM_PINS; i++) {
+    level[i] = true;  // подтяжки и свободная линия ИК
+    out[i] = false;
+    mode[i] = INPUT;
+  }
+  memset(i2cDev, 0, sizeof(i2cDev));
+  i2cDev[SIM_I2C_MCU].present = true;
+  twiOp = TWI_IDLE;
+  twiDoneAt = twiStopAt = NEVER;
+  twint = twiOwned = i2cHang = false;
+  trAddr = -1;
+  i2cTransactions = i2cBytes = 0;
+  memset(eeMem, 0xFF, sizeof(eeMem));
+  memset(eeWrites, 0, sizeof(eeWrites));
+  eeDoneAt = NEVER;
+  rxHead = rxTail = txHead = txTail = 0;
+  txDoneAt = NEVER;
+  lineLen = 0;
+  uartLost = 0;
+  burstLen = 0;
+  memset(&disp, 0, sizeof(disp));
+  dispLit = dispPeriod = -1;
+  t1LastA = t1LastB = NEVER;
+  t2Last = 0;
+}
+
+// модель готова до конструкторов прошивки (EncButton читает выводы)
+__attribute__((constructor(101))) static void simInit() {
+  simReset();
+}
@@ -0,0 +1,121 @@
+#pragma once
+// Модель ATmega168 для прогона прошивки на ПК (env:native).
+//
+// Время модельное, в тактах 16 МГц, и идёт только внутри simRun*(),
+// delay(), yield(), Serial.flush() и sleep_cpu(): сама прошивка исполняется
+// мгновенно, время между вызовами loop() продвигает тот, кто её гоняет
+// (см. replay.h). По ходу времени модель выставляет флаги периферии и
+// вызывает обработчики ISR() в порядке приоритета векторов AVR, если
+// прерывания разрешены.
+//
+// Что моделируется:
+//   Timer1 - счёт с делителем из TCCR1B, совпадения OCR1A/OCR1B;
+//   Timer2 - режим CTC по OCR2A (опрос ИК каждые 50 мкс);
+//   millis()/micros() - Timer0, во сне стоят вместе с остальными таймерами;
+//   TWI - ведущий передатчик и ведомые, подтверждающие байты или
+//         отвечающие NACK (simI2cNack); транзакции пишутся в лог;
+//   EEPROM - 512 байт, запись байта 3.4 мс, прерывание EE_READY,
+//         счётчики записей по адресам для тестов износа;
+//   UART - очередь приёма и буфер передачи на 64 байта со скоростью begin();
+//         байт, пришедший во сне, только будит МК (PCINT16) и теряется;
+//   выводы - уровни входов, PCINT0..2 и INT0 по изменению;
+//   индикация - по записям в PORTB/PORTD восстанавливаются сегменты
+//         разрядов, время свечения и смены изображения (кадры).
+//
+// Лог модели - строки "время_мс событие", например
+//   "  120.250 i2c 41: 00 3C 3C 00 10 00"
+//   "  123.000 disp 25"
+//   "  130.400 uart A5 06 81 19 00 00 00 00 45"   (передача без пауз)
+//   "  200.000 sleep", "  950.000 wake"
+//   "  300.000 eeprom 01F 05"                     (записан байт)
+
+#include <Arduino.h>
+
+#define SIM_HZ 16000000ULL
+#define SIM_CYCLES_US(us) ((uint64_t) (us) * (SIM_HZ / 1000000ULL))
+#define SIM_CYCLES_MS(ms) ((uint64_t) (ms) * (SIM_HZ / 1000ULL))
+
+#define SIM_PINS 20
+#define SIM_EEPROM_SIZE (E2END + 1)
+#define SIM_UART_TX_BUF 64
+#define SIM_UART_RX_BUF 64
+#define SIM_EE_WRITE_US 3400
+#define SIM_I2C_MCU 0x41
+#define SIM_WAKE_CYCLES 16384    // запуск кварца после power-save (фьюзы Nano: 16K CK)
+
+// векторы в порядке приоритета
+#define SIM_INT0         0
+#define SIM_PCINT0       1
+#define SIM_PCINT1       2
+#define SIM_PCINT2       3
+#define SIM_TIMER2_COMPA 4
+#define SIM_TIMER1_COMPA 5
+#define SIM_TIMER1_COMPB 6
+#define SIM_EE_READY     7
+#define SIM_TWI          8
+#define SIM_VECTORS      9
+
+typedef void (*simLogHandler)(const char *line);
+
+typedef struct {
+  uint8_t seg[2];             // сегменты разрядов последнего кадра, биты GFEDCBA
+  uint32_t frames;            // смен изображения
+  uint32_t scans[2];          // периодов разряда (разряд сменил другой)
+  uint64_t onCycles[2];       // время свечения разряда с сегментами
+} simDisplayStruct;
+
+// сброс модели: время 0, EEPROM стёрт (0xFF), очереди и счётчики пусты.
+// Статические переменные прошивки он не трогает.
+void simReset();
+// куда писать лог, NULL - никуда
+void simSetLog(simLogHandler h);
+void simLog(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+uint64_t simNow();              // такты
+uint64_t simNowUs();
+void simRunUntil(uint64_t cycles);
+void simRunUs(uint64_t us);
+// МК внутри sleep_cpu()
+bool simSleeping();
+// такты вне сна (часы таймеров), остальное от simNow() МК провёл в power-save
+uint64_t simAwakeCycles();
+// дальше этого момента sleep_cpu() не ждёт пробуждения и возвращается
+void simSetHorizon(uint64_t cycles);
+
+// уровень входа сейчас или в момент cycles
+void simPinSet(uint8_t pin, bool level);
+void simPinAt(uint64_t cycles, uint8_t pin, bool level);
+bool simPinGet(uint8_t pin);
+// входные события, которые ещё не наступили
+uint32_t simPendingInputs();
+
+// байты в приёмник UART с темпом линии, начиная с момента cycles
+void simSerialAt(uint64_t cycles, const uint8_t *data, uint16_t len);
+// забрать ушедшее в линию, вернёт число байт
+uint16_t simSerialTake(uint8_t *buf, uint16_t max);
+uint32_t simSerialLost();       // переполнение приёма и байты, пришедшие во сне
+
+// ведомые I2C, по умолчанию есть только SIM_I2C_MCU
+void simI2cDevice(uint8_t addr, bool present);
+// NACK на байт данных номер n (с 0, субадрес - нулевой) в следующих count транзакциях
+void simI2cNack(uint8_t addr, uint8_t n, uint16_t count);
+// SDA прижата: START не завершается, пока не будет 9 импульсов SCL (busRecover)
+void simI2cHang(bool hang);
+uint32_t simI2cTransactions();  // завершённых STOP, включая отвергнутые
+uint32_t simI2cBytes();         // байт на шине, включая SLA+W
+// регистр ведомого после принятых записей с автоинкрементом субадреса
+uint8_t simI2cReg(uint8_t addr, uint8_t reg);
+
+uint8_t *simEeprom();
+uint32_t simEepromWrites(uint16_t addr);
+// адрес в EEPROM переменной EEMEM
+uint16_t simEepromAddr(const void *p);
+// отключение питания посреди записи: байт остаётся стёртым (0xFF)
+void simEepromPowerLoss();
+
+simDisplayStruct simDisplay();
+void simDisplayClear();
+// символ шрифта прошивки с такими сегментами, '?' если его нет
+char simGlyphChar(uint8_t seg);
+
+uint32_t simIsrCount(uint8_t vector);
@@ -0,0 +1,20 @@
+#pragma once
+// ATOMIC_BLOCK из avr-libc поверх флага I модели
+
+#include <avr/interrupt.h>
+
+static inline uint8_t simAtomicEnter(uint8_t forceOn) {
+  uint8_t s = SREG;
+  cli();
+  return forceOn ? _BV(SREG_I) : s;
+}
+
+static inline void simAtomicLeave(const uint8_t *s) {
+  SREG = *s;
+}
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 1
+#define ATOMIC_BLOCK(type) \
+  for (uint8_t simSreg __attribute__((__cleanup__(simAtomicLeave))) = simAtomicEnter(type), simOnce = 1; \
+       simOnce; simOnce = 0)
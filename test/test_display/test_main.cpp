@@ -0,0 +1,80 @@
+// Развёртка индикации в TIMER1_COMPA: частота обновления и время свечения
+// разрядов на каждом уровне яркости (BCM), очередь бегущих строк.
+// loop() здесь не крутится, развёртка идёт сама по прерываниям, а
+// displayTick() вызывает тест.
+#include <unity.h>
+#include <stdio.h>
+#include "replay.h"
+#include "display.h"
+
+#define RUN_MS 500
+
+void setUp() {
+  displayNumber(88); // все сегменты обоих разрядов
+  displaySetBrightness(DISP_BRIGHT_MAX);
+  simRunUs(10000);
+}
+
+void tearDown() {}
+
+static simDisplayStruct measure(uint32_t ms) {
+  simDisplayClear();
+  simRunUs(ms * 1000UL);
+  return simDisplay();
+}
+
+// каждый разряд сменяется каждые DISP_DIGIT_US: кадр обновляется 500 раз в секунду
+void test_refresh_rate() {
+  simDisplayStruct d = measure(RUN_MS);
+  uint32_t expected = RUN_MS * 1000UL / DISP_DIGIT_US / 2;
+  printf("  refresh %lu Hz, digit period %u us\n", (unsigned long) (d.scans[0] * 1000UL / RUN_MS), DISP_DIGIT_US);
+  TEST_ASSERT_UINT32_WITHIN(1, expected, d.scans[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, expected, d.scans[1]);
+}
+
+// доля свечения разряда растёт линейно с уровнем, частота от него не зависит
+void test_on_time_per_level() {
+  uint64_t window = SIM_CYCLES_MS(RUN_MS);
+  for (uint8_t level = 0; level <= DISP_BRIGHT_MAX; level++) {
+    displaySetBrightness(level);
+    simRunUs(10000);
+    simDisplayStruct d = measure(RUN_MS);
+    // разряд горит половину времени, из неё level / DISP_BRIGHT_MAX
+    uint32_t expected = 1000UL * level / DISP_BRIGHT_MAX / 2;
+    for (uint8_t i = 0; i < 2; i++) {
+      uint32_t duty = d.onCycles[i] * 1000 / window;
+      printf("  level %2u digit %u: on %3lu/1000, %lu us per scan\n", level, i, (unsigned long) duty,
+             (unsigned long) (d.scans[i] ? d.onCycles[i] / d.scans[i] / SIM_CYCLES_US(1) : 0));
+      TEST_ASSERT_UINT32_WITHIN(5, expected, duty);
+      // на нулевом уровне разряд не включается вовсе
+      if (level) TEST_ASSERT_UINT32_WITHIN(1, RUN_MS * 1000UL / DISP_DIGIT_US / 2, d.scans[i]);
+    }
+  }
+}
+
+// после очереди сообщений возвращается изображение до первого из них
+void test_scroll_queue_restores() {
+  displayNumber(42);
+  dispStruct before = displayGet();
+  TEST_ASSERT_TRUE(displayScroll_P(PSTR("AB")));
+  TEST_ASSERT_TRUE(displayScroll_P(PSTR("CDE")));
+  uint16_t ms = 0;
+  while (displayScrolling() && ms < 10000) {
+    displayTick();
+    simRunUs(1000);
+    ms++;
+  }
+  TEST_ASSERT_FALSE(displayScrolling());
+  dispStruct after = displayGet();
+  TEST_ASSERT_EQUAL_HEX8(before.d1, after.d1);
+  TEST_ASSERT_EQUAL_HEX8(before.d2, after.d2);
+}
+
+int main() {
+  replayBoot();
+  UNITY_BEGIN();
+  RUN_TEST(test_refresh_rate);
+  RUN_TEST(test_on_time_per_level);
+  RUN_TEST(test_scroll_queue_restores);
+  return UNITY_END();
+}
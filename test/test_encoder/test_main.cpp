@@ -0,0 +1,89 @@
+// Очередь поворотов энкодера (EB_FIFO_SIZE): переполнение, ускорение delta()
+// и таймаут после поворота. loop() здесь не крутится, очередь разбирает
+// тест вызовом eb.tick(), как это делает encoderTick().
+#include <unity.h>
+#include "replay.h"
+#define EB_FIFO_SIZE 16 // как в main.cpp, иначе у eb другая раскладка
+#include "EncButton.h"
+
+extern EncButton eb;
+
+#define ACCEL_MS  60 // ENC_ACCEL_MS, ENC_ACCEL_MAX из main.cpp
+#define ACCEL_MAX 5
+
+static uint32_t t;
+
+// разобрать очередь, шаги delta() в steps
+static uint8_t drain(int8_t *steps, uint8_t max) {
+  uint8_t n = 0;
+  while (eb.tick(), eb.turn()) {
+    int8_t d = eb.delta();
+    if (n < max) steps[n] = d;
+    n++;
+  }
+  return n;
+}
+
+void setUp() {
+  int8_t steps[1];
+  drain(steps, 0);
+  t = replayNowMs() + 500;
+}
+
+void tearDown() {}
+
+// щелчков больше, чем мест в очереди: лишние считаются, а не портят очередь
+void test_fifo_overflow() {
+  uint8_t lost = eb.lostTurns();
+  replayEncoder(t, EB_FIFO_SIZE + 4, 10);
+  simRunUntil(SIM_CYCLES_MS(t + (EB_FIFO_SIZE + 4) * 10 + 50));
+  TEST_ASSERT_EQUAL(4, eb.lostTurns() - lost);
+  int8_t steps[EB_FIFO_SIZE + 4];
+  TEST_ASSERT_EQUAL(EB_FIFO_SIZE, drain(steps, sizeof(steps)));
+  for (uint8_t i = 0; i < EB_FIFO_SIZE; i++) TEST_ASSERT_GREATER_THAN(0, steps[i]);
+}
+
+// шаг растёт линейно с частотой щелчков, интервал берётся из прерывания,
+// а не из того, когда очередь разобрали
+void test_accel() {
+  static const uint16_t interval[] = {200, 60, 30, 12};
+  for (uint8_t k = 0; k < sizeof(interval) / sizeof(interval[0]); k++) {
+    uint16_t ms = interval[k];
+    replayEncoder(t, -3, ms);
+    simRunUntil(SIM_CYCLES_MS(t + 3 * ms + 50));
+    int8_t steps[3];
+    TEST_ASSERT_EQUAL(3, drain(steps, 3));
+    uint8_t expected = ms < ACCEL_MS ? 1 + (ACCEL_MS - ms) * (ACCEL_MAX - 1) / ACCEL_MS : 1;
+    // первый щелчок после паузы всегда одиночный
+    TEST_ASSERT_EQUAL(-1, steps[0]);
+    TEST_ASSERT_EQUAL(-expected, steps[1]);
+    TEST_ASSERT_EQUAL(-expected, steps[2]);
+    t = replayNowMs() + 500;
+  }
+}
+
+// timeout() отсчитывается от поворота, взятого из очереди
+void test_timeout_after_turn() {
+  simRunUntil(SIM_CYCLES_MS(t));
+  eb.tick();
+  eb.timeout(0);  // сбросить таймаут прошлых тестов
+  replayEncoder(t + 10, 1, 20);
+  simRunUntil(SIM_CYCLES_MS(t + 20));
+  eb.tick();
+  TEST_ASSERT_TRUE(eb.turn());
+  simRunUntil(SIM_CYCLES_MS(t + 220));
+  eb.tick();
+  TEST_ASSERT_FALSE(eb.timeout(300));
+  simRunUntil(SIM_CYCLES_MS(t + 340));
+  eb.tick();
+  TEST_ASSERT_TRUE(eb.timeout(300));
+}
+
+int main() {
+  replayBoot();
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_overflow);
+  RUN_TEST(test_accel);
+  RUN_TEST(test_timeout_after_turn);
+  return UNITY_END();
+}
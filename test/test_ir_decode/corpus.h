@@ -0,0 +1,127 @@
+#pragma once
+// Кадры пультов для проверки разбора ИК, длительности в мкс начиная с импульса.
+// Кадры собираются по описанию протоколов (константы из ir_*.cpp) и
+// проходят через вывод 2 и прерывание приёма, как настоящие.
+
+#include <stdint.h>
+
+#define CORPUS_MAX 120
+
+typedef struct {
+  const char *name;
+  uint16_t us[CORPUS_MAX];
+  uint8_t len;
+} corpusFrame;
+
+static void corpusPut(corpusFrame &f, uint16_t us) {
+  if (f.len < CORPUS_MAX) f.us[f.len++] = us;
+}
+
+// уровень на полубит Манчестера: склеить одинаковые соседние
+static void corpusLevel(corpusFrame &f, bool mark, uint16_t us, bool &cur) {
+  if (f.len && cur == mark) {
+    f.us[f.len - 1] += us;
+    return;
+  }
+  if (!f.len && !mark) return;  // пауза до первого импульса не видна
+  corpusPut(f, us);
+  cur = mark;
+}
+
+// заголовок, биты расстоянием между импульсами, стоп
+static corpusFrame pulseDistance(const char *name, uint16_t hdrMark, uint16_t hdrSpace, uint16_t bitMark,
+                                 uint16_t oneSpace, uint16_t zeroSpace, uint64_t data, uint8_t bits) {
+  corpusFrame f = {name, {0}, 0};
+  if (hdrMark) {
+    corpusPut(f, hdrMark);
+    corpusPut(f, hdrSpace);
+  }
+  for (int8_t i = bits - 1; i >= 0; i--) {
+    corpusPut(f, bitMark);
+    corpusPut(f, (data >> i) & 1 ? oneSpace : zeroSpace);
+  }
+  corpusPut(f, bitMark);
+  return f;
+}
+
+// Sony: биты шириной импульса, без стопа
+static corpusFrame sony(const char *name, uint32_t data, uint8_t bits) {
+  corpusFrame f = {name, {2400, 600}, 2};
+  for (int8_t i = bits - 1; i >= 0; i--) {
+    corpusPut(f, (data >> i) & 1 ? 1200 : 600);
+    if (i) corpusPut(f, 600);
+  }
+  return f;
+}
+
+// RC5: 14 бит (старт 1, 1, переключатель, 5 адрес, 6 команда), 1 - пауза, потом импульс
+static corpusFrame rc5(const char *name, uint16_t data) {
+  corpusFrame f = {name, {0}, 0};
+  bool cur = false;
+  for (int8_t i = 13; i >= 0; i--) {
+    bool one = (data >> i) & 1;
+    corpusLevel(f, !one, 889, cur);
+    corpusLevel(f, one, 889, cur);
+  }
+  return f;
+}
+
+// RC6 режим 0: лидер, старт 1, режим 000, переключатель двойной ширины, 16 бит; 1 - импульс, потом пауза
+static corpusFrame rc6(const char *name, uint16_t data, bool toggle) {
+  corpusFrame f = {name, {2666, 889}, 2};
+  bool cur = false;
+  for (int8_t i = 4; i >= 0; i--) {
+    bool one = i == 4 || (i == 0 && toggle);
+    uint16_t t = i == 0 ? 889 : 444;
+    corpusLevel(f, one, t, cur);
+    corpusLevel(f, !one, t, cur);
+  }
+  for (int8_t i = 15; i >= 0; i--) {
+    bool one = (data >> i) & 1;
+    corpusLevel(f, one, 444, cur);
+    corpusLevel(f, !one, 444, cur);
+  }
+  if (!cur) f.len--;  // последняя пауза сливается с паузой после кадра
+  return f;
+}
+
+static uint8_t corpusBuild(corpusFrame *c) {
+  uint8_t n = 0;
+  c[n++] = pulseDistance("nec", 9000, 4500, 560, 1690, 560, 0x00FB906F, 32);
+  c[n++] = pulseDistance("nec 2", 9000, 4500, 560, 1690, 560, 0x20DF10EF, 32);
+  c[n++] = corpusFrame {"nec repeat", {9000, 2250, 560}, 3};
+  c[n++] = sony("sony 12", 0xA90, 12);
+  c[n++] = sony("sony 15", 0x5A5A, 15);
+  c[n++] = pulseDistance("samsung", 4500, 4500, 560, 1600, 560, 0xE0E040BF, 32);
+  c[n++] = pulseDistance("jvc", 8400, 4200, 600, 1600, 550, 0xC5E8, 16);
+  c[n++] = pulseDistance("jvc repeat", 0, 0, 600, 1600, 550, 0xC5E8, 16);
+  c[n++] = pulseDistance("lg", 8400, 4200, 600, 1600, 550, 0x88C0051, 28);
+  // 48 бит не помещаются в RAW_BUFFER_LENGTH прошивки: кадр отбрасывается
+  c[n++] = pulseDistance("panasonic", 3502, 1750, 502, 1244, 400, 0x40040100BCBDULL, 48);
+  c[n++] = pulseDistance("whynter", 2850, 2850, 750, 2150, 750, 0x12345678, 32);
+  c[n++] = pulseDistance("denon", 300, 750, 300, 1800, 750, 0x2A4C, 14);
+  c[n++] = pulseDistance("sharp", 0, 0, 250, 1805, 795, 0x41F2, 15);
+  c[n++] = rc5("rc5", 0x31A3);
+  c[n++] = rc5("rc5 toggle", 0x39A3);
+  c[n++] = rc6("rc6", 0x040C, false);
+  c[n++] = rc6("rc6 toggle", 0x040C, true);
+  c[n++] = corpusFrame {"noise", {700, 1300, 300, 2900, 1500, 450, 950, 600, 2200, 350, 800}, 11};
+  c[n++] = corpusFrame {"short", {600, 600, 600}, 3};
+  return n;
+}
+
+// результат разбора эталонной цепочкой декодеров (IR_DECODE_CHAIN),
+// пересобрать: env:native_ir_chain с -D IR_CORPUS_RECORD, строки "  {{" из
+// вывода теста записать в corpus_expected.h
+typedef struct {
+  bool decoded;
+  int8_t type;
+  uint32_t value;
+  uint8_t bits;
+  uint16_t address;
+} corpusResult;
+
+static const corpusResult corpusExpected[][2] = {
+  // decode(),                                  decode(decode_results *)
+#include "corpus_expected.h"
+};
@@ -0,0 +1,19 @@
+  {{1, 11, 0x00FB906F, 32, 0x0000}, {1, 11, 0x00FB906F, 32, 0x0000}}, // nec
+  {{1, 11, 0x20DF10EF, 32, 0x0000}, {1, 11, 0x20DF10EF, 32, 0x0000}}, // nec 2
+  {{1, 11, 0xFFFFFFFF, 0, 0x0000}, {1, 11, 0xFFFFFFFF, 0, 0x0000}}, // nec repeat
+  {{1, 19, 0x00000A90, 12, 0x0000}, {1, 19, 0x00000A90, 12, 0x0000}}, // sony 12
+  {{1, 19, 0x00005A5A, 15, 0x0000}, {1, 19, 0x00005A5A, 15, 0x0000}}, // sony 15
+  {{1, 15, 0xE0E040BF, 32, 0x0000}, {1, 15, 0xE0E040BF, 32, 0x0000}}, // samsung
+  {{1, 5, 0x0000C5E8, 16, 0x0000}, {1, 5, 0x0000C5E8, 16, 0x0000}}, // jvc
+  {{1, 5, 0xFFFFFFFF, 0, 0x0000}, {1, 5, 0xFFFFFFFF, 0, 0x0000}}, // jvc repeat
+  {{1, 7, 0x088C0051, 28, 0x0000}, {1, 7, 0x088C0051, 28, 0x0000}}, // lg
+  {{0, 0, 0x00000000, 0, 0x0000}, {0, 0, 0x00000000, 0, 0x0000}}, // panasonic
+  {{1, 16, 0x12345678, 33, 0x0000}, {1, 16, 0x12345678, 33, 0x0000}}, // whynter
+  {{1, 17, 0x00000000, 15, 0x000A}, {1, 17, 0x00000000, 15, 0x000A}}, // denon
+  {{1, 17, 0x00000000, 15, 0x0010}, {1, 17, 0x00000000, 15, 0x0010}}, // sharp
+  {{1, 13, 0x000001A3, 12, 0x0000}, {1, 13, 0x000001A3, 12, 0x0000}}, // rc5
+  {{1, 13, 0x000009A3, 12, 0x0000}, {1, 13, 0x000009A3, 12, 0x0000}}, // rc5 toggle
+  {{1, 14, 0x0000040C, 20, 0x0000}, {1, 14, 0x0000040C, 20, 0x0000}}, // rc6
+  {{1, 14, 0x0001040C, 20, 0x0000}, {1, 14, 0x0001040C, 20, 0x0000}}, // rc6 toggle
+  {{1, -1, 0xF40E874F, 32, 0x0000}, {1, -1, 0xF40E874F, 32, 0x0000}}, // noise
+  {{0, 0, 0x00000000, 0, 0x0000}, {0, 0, 0x00000000, 0, 0x0000}}, // short
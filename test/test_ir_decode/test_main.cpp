@@ -0,0 +1,149 @@
+// Разбор ИК по сигнатурам даёт то же, что прежняя цепочка декодеров.
+// Набор запускается в env:native_ir (IR_RAW_COMPACT), env:native_ir_wide
+// (16-битный rawbuf) и env:native_ir_chain (IR_DECODE_CHAIN, эталон), и в
+// каждом печатает время разбора кадра на ПК и число вызванных декодеров.
+// Время на ПК плавает от прогона к прогону, число вызовов от машины не
+// зависит и показывает, сколько работы сигнатуры снимают с loop() на МК.
+#include <unity.h>
+#include <time.h>
+#include <stdio.h>
+#include "replay.h"
+#include "IRremote.h"
+#include "corpus.h"
+
+#if !defined(IR_DECODE_STATS)
+#error "test_ir_decode runs in env:native_ir*, they define IR_DECODE_STATS"
+#endif
+
+extern IRrecvT<2> IrReceiver;
+
+#define BENCH_ROUNDS 2000
+#define BENCH_TRIES 7   // лучший из прогонов, остальные - шум планировщика
+
+static corpusFrame corpus[32];
+static uint8_t corpusLen;
+
+void setUp() {}
+
+void tearDown() {}
+
+// кадр через вывод приёмника и прерывание Timer2, loop() не крутится
+static void receive(const corpusFrame &f) {
+  uint32_t t = simNowUs() / 1000 + 20;
+  replayIrRaw(t, f.us, f.len);
+  uint32_t us = 0;
+  for (uint8_t i = 0; i < f.len; i++) us += f.us[i];
+  simRunUntil(SIM_CYCLES_MS(t + 10) + SIM_CYCLES_US(us));
+}
+
+static corpusResult result(bool decoded, const decode_results &r) {
+  corpusResult c = {decoded, 0, 0, 0, 0};
+  if (decoded) {
+    c.type = r.decode_type;
+    c.value = r.value;
+    c.bits = r.bits;
+    c.address = r.address;
+  }
+  return c;
+}
+
+static bool same(const corpusResult &a, const corpusResult &b) {
+  return a.decoded == b.decoded && a.type == b.type && a.value == b.value && a.bits == b.bits
+         && a.address == b.address;
+}
+
+static void print(const corpusResult &c, const char *end) {
+  printf("{%d, %d, 0x%08lX, %u, 0x%04X}%s", c.decoded, c.type, (unsigned long) c.value, c.bits, c.address, end);
+}
+
+void test_corpus_matches_chain() {
+  uint8_t bad = 0;
+  unsigned int overflows = IrReceiver.getOverflows();
+  unsigned int tooLong = 0;
+  for (uint8_t i = 0; i < corpusLen; i++) {
+    // кадр длиннее rawbuf (с паузой перед ним) отбрасывается и считается
+    if (corpus[i].len + 1 > RAW_BUFFER_LENGTH) tooLong++;
+    receive(corpus[i]);
+    // оба вызова читают один и тот же кадр, resume() освобождает его
+    bool ok = IrReceiver.decode();
+    corpusResult now = result(ok, IrReceiver.results);
+    corpusResult old = now;
+    if (ok) {
+      decode_results r;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+      old = result(IrReceiver.decode(&r), r);
+#pragma GCC diagnostic pop
+      IrReceiver.resume();
+    }
+#ifdef IR_CORPUS_RECORD
+    printf("  {");
+    print(now, ", ");
+    print(old, "},");
+    printf(" // %s\n", corpus[i].name);
+#else
+    if (i >= sizeof(corpusExpected) / sizeof(corpusExpected[0])) {
+      printf("%s: no expected result\n", corpus[i].name);
+      bad++;
+      continue;
+    }
+    for (uint8_t api = 0; api < 2; api++) {
+      const corpusResult &got = api ? old : now;
+      if (same(got, corpusExpected[i][api])) continue;
+      printf("%s, %s: got ", corpus[i].name, api ? "decode(decode_results *)" : "decode()");
+      print(got, ", expected ");
+      print(corpusExpected[i][api], "\n");
+      bad++;
+    }
+#endif
+  }
+  TEST_ASSERT_EQUAL(0, bad);
+  TEST_ASSERT_EQUAL(tooLong, IrReceiver.getOverflows() - overflows);
+}
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// повторный decode() без resume() разбирает тот же кадр заново
+static uint64_t decodeNs() {
+  uint64_t best = UINT64_MAX;
+  for (uint8_t t = 0; t < BENCH_TRIES; t++) {
+    uint64_t t0 = nowNs();
+    for (uint16_t n = 0; n < BENCH_ROUNDS; n++) IrReceiver.decode();
+    uint64_t ns = (nowNs() - t0) / BENCH_ROUNDS;
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+void test_decode_time() {
+  uint64_t total = 0;
+  uint32_t calls = 0;
+  uint16_t frames = 0;
+  for (uint8_t i = 0; i < corpusLen; i++) {
+    receive(corpus[i]);
+    unsigned long before = IrReceiver.decoderCalls;
+    if (!IrReceiver.decode()) continue;
+    unsigned long n = IrReceiver.decoderCalls - before;
+    uint64_t ns = decodeNs();
+    IrReceiver.resume();
+    printf("  %-12s %6lu ns %3lu decoders\n", corpus[i].name, (unsigned long) ns, n);
+    total += ns;
+    calls += n;
+    frames++;
+  }
+  printf("  %-12s %6lu ns %3lu decoders per frame (%u frames)\n", "mean", (unsigned long) (total / frames),
+         (unsigned long) ((calls + frames / 2) / frames), frames);
+}
+
+int main() {
+  corpusLen = corpusBuild(corpus);
+  replayBoot();
+  UNITY_BEGIN();
+  RUN_TEST(test_corpus_matches_chain);
+  RUN_TEST(test_decode_time);
+  return UNITY_END();
+}
@@ -0,0 +1,68 @@
+// Приём ИК по фронтам INT0 (env:native_edge, -D IR_EDGE_CAPTURE).
+// loop() здесь не крутится: кадры копятся в кольце, как когда прошивка
+// занята, и разбираются потом.
+#include <unity.h>
+#include "replay.h"
+#include "IRremote.h"
+
+extern IRrecvT<2> IrReceiver;
+
+#define CODE_A 0x00FB906F
+#define CODE_B 0x00FBA05F
+
+static uint32_t t;
+
+void setUp() {
+  decode_results r;
+  while (IrReceiver.decode(&r)) IrReceiver.resume();
+  t = simNowUs() / 1000 + 200;
+}
+
+void tearDown() {}
+
+static uint8_t decodeAll(uint32_t *codes, uint8_t max) {
+  decode_results r;
+  uint8_t n = 0;
+  while (n < max && IrReceiver.decode(&r)) {
+    codes[n++] = r.value;
+    IrReceiver.resume();
+  }
+  return n;
+}
+
+// пауза между кадрами закончилась раньше, чем её заметил irCheckGap():
+// фронт нового кадра сам закрывает предыдущий
+void test_back_to_back_frames() {
+  unsigned int overflows = IrReceiver.getOverflows();
+  replayIrNec(t, CODE_A);
+  replayIrNec(t + 110, CODE_B);
+  simRunUntil(SIM_CYCLES_MS(t + 300));
+  uint32_t codes[4];
+  TEST_ASSERT_EQUAL(2, decodeAll(codes, 4));
+  TEST_ASSERT_EQUAL_HEX32(CODE_A, codes[0]);
+  TEST_ASSERT_EQUAL_HEX32(CODE_B, codes[1]);
+  TEST_ASSERT_EQUAL(overflows, IrReceiver.getOverflows());
+}
+
+// кадров больше, чем IR_FRAME_SLOTS: лишние отбрасываются и считаются
+void test_frame_then_repeats() {
+  unsigned int dropped = IrReceiver.getDropped();
+  replayIrNec(t, CODE_A);
+  replayIrRepeat(t + 108);
+  replayIrRepeat(t + 216);
+  simRunUntil(SIM_CYCLES_MS(t + 400));
+  uint32_t codes[4];
+  uint8_t kept = IR_FRAME_SLOTS < 3 ? IR_FRAME_SLOTS : 3;
+  TEST_ASSERT_EQUAL(kept, decodeAll(codes, 4));
+  TEST_ASSERT_EQUAL(3 - kept, IrReceiver.getDropped() - dropped);
+  TEST_ASSERT_EQUAL_HEX32(CODE_A, codes[0]);
+  for (uint8_t i = 1; i < kept; i++) TEST_ASSERT_EQUAL_HEX32(REPEAT, codes[i]);
+}
+
+int main() {
+  replayBoot();
+  UNITY_BEGIN();
+  RUN_TEST(test_back_to_back_frames);
+  RUN_TEST(test_frame_then_repeats);
+  return UNITY_END();
+}
@@ -0,0 +1,69 @@
+// Такты обработки приёма ИК в прерывании Timer2 (50 мкс), simavr only:
+//   pio test -e simavr
+// Сравниваются IRrecvT<2>::tickISR() (вывод читается gio::read() с
+// известным при сборке номером) и прежний путь библиотечного прерывания
+// через digitalRead(). Счёт - Timer1 без делителя, прерывания запрещены,
+// вызов пустой функции вычитается. Вход и выход из прерывания (около 40
+// тактов) в обоих случаях одинаковы и сюда не входят.
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include "IRremote.h"
+
+#define IR_PIN 2
+#define CALLS 256
+
+static IRrecvT<IR_PIN> rx;
+
+__attribute__((noinline)) static void tickEmpty() {
+  asm volatile("");
+}
+
+__attribute__((noinline)) static void tickPinT() {
+  rx.tickISR();
+}
+
+__attribute__((noinline)) static void tickDigitalRead() {
+  irRecordTick(digitalRead(IR_PIN));
+}
+
+static uint16_t cycles(void (*f)()) {
+  cli();
+  TCNT1 = 0;
+  for (uint16_t i = 0; i < CALLS; i++) f();
+  uint16_t t = TCNT1;
+  sei();
+  return t / CALLS;
+}
+
+static void report(const char *name, uint16_t c) {
+  char s[48];
+  snprintf(s, sizeof(s), "%s: %u cycles", name, c);
+  TEST_MESSAGE(s);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// приёмник молчит (SPACE), самый частый случай: пауза между кадрами
+void test_idle_tick() {
+  // enableIRIn() не нужен: Timer2 и его прерывание тут не участвуют
+  pinMode(IR_PIN, INPUT_PULLUP);
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  uint16_t empty = cycles(tickEmpty);
+  uint16_t pinT = cycles(tickPinT) - empty;
+  uint16_t dr = cycles(tickDigitalRead) - empty;
+  report("IRrecvT<2>::tickISR", pinT);
+  report("digitalRead + irRecordTick", dr);
+  TEST_ASSERT_LESS_THAN(dr, pinT);
+}
+
+void setup() {
+  UNITY_BEGIN();
+  RUN_TEST(test_idle_tick);
+  UNITY_END();
+}
+
+void loop() {}
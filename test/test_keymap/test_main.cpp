@@ -0,0 +1,155 @@
+// Поиск кода пульта: keymapFind() (выученные коды, затем бинарный поиск
+// по отсортированным кодам во flash) против прежнего getKeyByCode() -
+// switch по кодам обоих пультов. Оба должны находить одно и то же; тест
+// печатает время на ПК и сколько байт данных из flash (инструкций LPM на
+// МК) уходит на поиск. У switch коды лежат в самих инструкциях сравнения,
+// данных он не читает.
+#include <unity.h>
+#include <time.h>
+#include <stdio.h>
+#include "replay.h"
+#include "keymap.h"
+
+#define BENCH_ROUNDS 20000
+#define BENCH_REPEATS 7
+
+typedef struct {
+  uint32_t code;
+  uint8_t key;
+} keyRow;
+
+// строки keyTable из keymap.cpp для пультов по умолчанию, в порядке описания
+static const keyRow rows[] PROGMEM = {
+  {4294967295, KEY_REPEAT},
+  {16460501, KEY_MUTE}, {16476311, KEY_INPUT_CH}, {16486511, KEY_VOL_UP}, {16490591, KEY_VOL_DOWN},
+  {16494671, KEY_BASS_UP}, {16462541, KEY_BASS_DOWN}, {16484471, KEY_TREB_UP}, {16452341, KEY_TREB_DOWN},
+  {2155823295, KEY_MUTE}, {2155815135, KEY_INPUT_CH}, {2155841655, KEY_VOL_UP}, {2155809015, KEY_VOL_DOWN},
+  {2155827375, KEY_BASS_UP}, {2155835535, KEY_BASS_DOWN}, {2155843695, KEY_TREB_UP}, {2155851855, KEY_TREB_DOWN},
+};
+#define ROWS (sizeof(rows) / sizeof(rows[0]))
+
+// коды чужих пультов
+static const uint32_t unknown[] = {0, 1, 0x00FF02FD, 0x20DF10EF, 0x807F00FF, 2155851856, 0xFFFFFFFE};
+#define UNKNOWN (sizeof(unknown) / sizeof(unknown[0]))
+
+// getKeyByCode() до keymap.cpp, без печати неизвестного кода в Serial
+static uint8_t switchFind(uint32_t irCode) {
+  switch(irCode){
+    case 16460501: 
+    case 2155823295: // original Solo 7C
+      return KEY_MUTE;
+    case 16476311: 
+    case 2155815135: // original Solo 7C
+      return KEY_INPUT_CH;
+    case 16486511: 
+    case 2155841655: // original Solo 7C
+      return KEY_VOL_UP;
+    case 16490591: 
+    case 2155809015: // original Solo 7C
+      return KEY_VOL_DOWN;
+    case 16494671: 
+    case 2155827375: // original Solo 7C
+      return KEY_BASS_UP;
+    case 16462541: 
+    case 2155835535: // original Solo 7C
+      return KEY_BASS_DOWN;
+    case 16484471: 
+    case 2155843695: // original Solo 7C
+      return KEY_TREB_UP;
+    case 16452341: 
+    case 2155851855: // original Solo 7C
+      return KEY_TREB_DOWN;
+    case 4294967295: 
+      return KEY_REPEAT;
+    default: 
+      return KEY_UNDEFINED;
+  }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_same_keys() {
+  for (uint8_t i = 0; i < ROWS; i++) {
+    TEST_ASSERT_EQUAL(rows[i].key, keymapFind(rows[i].code));
+    TEST_ASSERT_EQUAL(rows[i].key, switchFind(rows[i].code));
+  }
+  for (uint8_t i = 0; i < UNKNOWN; i++) {
+    TEST_ASSERT_EQUAL(KEY_UNDEFINED, keymapFind(unknown[i]));
+    TEST_ASSERT_EQUAL(KEY_UNDEFINED, switchFind(unknown[i]));
+  }
+}
+
+// байт flash на поиск: средний и худший по набору кодов
+static void flashBytes(uint8_t (*find)(uint32_t), const uint32_t *codes, uint8_t n, uint32_t *mean,
+                       uint32_t *worst) {
+  uint32_t total = 0;
+  *worst = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    uint32_t before = simFlashBytes;
+    find(codes[i]);
+    uint32_t b = simFlashBytes - before;
+    total += b;
+    if (b > *worst) *worst = b;
+  }
+  *mean = (total + n / 2) / n;
+}
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static volatile uint8_t sink;
+
+// лучшее из BENCH_REPEATS измерений: на ПК мешают другие процессы
+static uint32_t lookupNs(uint8_t (*find)(uint32_t), const uint32_t *codes, uint8_t n) {
+  uint64_t best = UINT64_MAX;
+  for (uint8_t k = 0; k < BENCH_REPEATS; k++) {
+    uint64_t t0 = nowNs();
+    for (uint16_t r = 0; r < BENCH_ROUNDS; r++) {
+      for (uint8_t i = 0; i < n; i++) sink = find(codes[i]);
+    }
+    uint64_t t = nowNs() - t0;
+    if (t < best) best = t;
+  }
+  return best / ((uint64_t) BENCH_ROUNDS * n);
+}
+
+static void report(const char *name, uint8_t (*find)(uint32_t), const uint32_t *hits, uint32_t *hitWorst,
+                   uint32_t *missWorst) {
+  uint32_t hitMean, missMean;
+  uint32_t hitNs = lookupNs(find, hits, ROWS), missNs = lookupNs(find, unknown, UNKNOWN);
+  flashBytes(find, hits, ROWS, &hitMean, hitWorst);
+  flashBytes(find, unknown, UNKNOWN, &missMean, missWorst);
+  printf("  %-8s flash bytes: hit %3lu (worst %3lu), miss %3lu (worst %3lu); host %3lu ns/hit, %3lu ns/miss\n",
+         name, (unsigned long) hitMean, (unsigned long) *hitWorst, (unsigned long) missMean,
+         (unsigned long) *missWorst, (unsigned long) hitNs, (unsigned long) missNs);
+}
+
+// switch данных не читает; бинарный поиск - не больше 5 кодов по 4 байта
+// и кнопка. Время на ПК только печатается: на x86 switch быстрее (коды -
+// операнды инструкций, выученных кодов он не знает), и о тактах МК с его
+// 32-битными сравнениями по байту оно говорит мало
+void test_lookup_cost() {
+  uint32_t hits[ROWS];
+  for (uint8_t i = 0; i < ROWS; i++) hits[i] = rows[i].code;
+  uint32_t binHit, binMiss, swHit, swMiss;
+  report("keymap", keymapFind, hits, &binHit, &binMiss);
+  report("switch", switchFind, hits, &swHit, &swMiss);
+  TEST_ASSERT_EQUAL(0, swHit);
+  TEST_ASSERT_EQUAL(0, swMiss);
+  TEST_ASSERT_LESS_OR_EQUAL(5 * 4 + 1, binHit);
+  TEST_ASSERT_LESS_OR_EQUAL(5 * 4, binMiss);
+}
+
+int main() {
+  replayBoot();
+  keymapForget(); // выученные коды проверяются до таблицы, здесь они не нужны
+  UNITY_BEGIN();
+  RUN_TEST(test_same_keys);
+  RUN_TEST(test_lookup_cost);
+  return UNITY_END();
+}
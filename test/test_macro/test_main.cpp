@@ -0,0 +1,55 @@
+// Макросы: одна кнопка пульта задаёт несколько полей состояния.
+#include <unity.h>
+#include "replay.h"
+#include "state.h"
+#include "macro.h"
+#include "mcu.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+// повторный запуск даёт то же состояние, а не накапливает бас
+void test_pc_macro_is_idempotent() {
+  for (uint8_t i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(macroRun(0));
+    replayRunFor(10);
+    TEST_ASSERT_EQUAL(PC, stateGet().inputCh);
+    TEST_ASSERT_FALSE(stateGet().isMute);
+    TEST_ASSERT_EQUAL(25, stateGet().volume);
+    TEST_ASSERT_EQUAL(2, stateGet().bass);
+    TEST_ASSERT_EQUAL(0, stateGet().treble);
+  }
+}
+
+// тот же вход - одна посылка в MCU на весь макрос, другой вход - рампа
+void test_macro_writes() {
+  TEST_ASSERT_TRUE(macroRun(1));
+  replayRunFor(300);
+  stateSetVolume(30);
+  stateSetBass(-3);
+  replayRunFor(50);
+  uint32_t tr = simI2cTransactions();
+  TEST_ASSERT_TRUE(macroRun(1));
+  replayRunFor(300);
+  TEST_ASSERT_EQUAL(1, simI2cTransactions() - tr);
+
+  tr = simI2cTransactions();
+  TEST_ASSERT_TRUE(macroRun(0));
+  replayRunFor(300);
+  TEST_ASSERT_GREATER_THAN(1, simI2cTransactions() - tr);
+  TEST_ASSERT_EQUAL_HEX8(B00100000, simI2cReg(MCU_ADR, MCU_REG_INPUT));
+}
+
+void test_unknown_macro() {
+  TEST_ASSERT_FALSE(macroRun(MACRO_COUNT));
+}
+
+int main() {
+  replayBoot();
+  UNITY_BEGIN();
+  RUN_TEST(test_pc_macro_is_idempotent);
+  RUN_TEST(test_macro_writes);
+  RUN_TEST(test_unknown_macro);
+  return UNITY_END();
+}
@@ -0,0 +1,177 @@
+// Передача регистров MCU по I2C: сколько байт уходит на шину за
+// записанные нажатия пульта и энкодера (прошивка целиком, с рампой),
+// склейка посылок, повторы после NACK и следующая посылка вне прерывания.
+// В тестах с mcuWrite() loop() не крутится, mcuTick() вызывает тест.
+#include <unity.h>
+#include <stdio.h>
+#include "replay.h"
+#include "state.h"
+#include "volcurve.h"
+#include "mcu.h"
+
+#define IR_MUTE 0x00FB2AD5
+#define BURST_VOL   (1 + 1 + 2)     // SLA+W, субадрес, L, R
+#define BURST_INPUT (1 + 1 + 3)     // SLA+W, субадрес, L, R, вход
+
+static byte regs[MCU_REGS];
+
+// mcuTick() с шагом прохода loop()
+static void tick(uint32_t ms) {
+  uint64_t end = simNow() + SIM_CYCLES_MS(ms);
+  while (simNow() < end) {
+    mcuTick();
+    simRunUs(REPLAY_LOOP_US);
+  }
+}
+
+void setUp() {
+  tick(50);
+  TEST_ASSERT_FALSE(mcuBusy());
+  for (uint8_t i = 0; i < MCU_REGS; i++) regs[i] = simI2cReg(MCU_ADR, i);
+}
+
+void tearDown() {}
+
+static void assertRegs() {
+  for (uint8_t i = 0; i < MCU_REGS; i++) TEST_ASSERT_EQUAL_HEX8(regs[i], simI2cReg(MCU_ADR, i));
+}
+
+typedef struct {
+  uint32_t tr;
+  uint32_t bytes;
+} wireStruct;
+
+// прогнать записанные входы до момента ms, что ушло на шину
+static wireStruct wire(const char *name, uint32_t ms) {
+  wireStruct w = {simI2cTransactions(), simI2cBytes()};
+  replayRun(ms);
+  w.tr = simI2cTransactions() - w.tr;
+  w.bytes = simI2cBytes() - w.bytes;
+  printf("  %-10s %3lu transactions, %4lu bytes on the wire\n", name, (unsigned long) w.tr, (unsigned long) w.bytes);
+  return w;
+}
+
+// снятие mute с пульта: вход переключается на шаге 1, затем подъём по
+// шагу за посылку; режим и EQ не меняются и на шину не идут
+void test_keys_unmute() {
+  TEST_ASSERT_TRUE(stateGet().isMute);
+  uint8_t vol = stateGet().volume;
+  uint32_t t = replayNowMs();
+  replayIrNec(t + 10, IR_MUTE);
+  wireStruct w = wire("unmute", t + 500);
+  TEST_ASSERT_FALSE(stateGet().isMute);
+  TEST_ASSERT_EQUAL(vol, w.tr);
+  TEST_ASSERT_EQUAL(BURST_INPUT + (vol - 1) * BURST_VOL, w.bytes);
+}
+
+// медленные щелчки энкодера: по посылке L, R на щелчок
+void test_keys_encoder() {
+  uint32_t t = replayNowMs();
+  replayEncoder(t + 10, 3, 200);
+  wireStruct w = wire("encoder +3", t + 900);
+  TEST_ASSERT_EQUAL(3, w.tr);
+  TEST_ASSERT_EQUAL(3 * BURST_VOL, w.bytes);
+  TEST_ASSERT_EQUAL_HEX8(volToReg(stateGet().volume), simI2cReg(MCU_ADR, MCU_REG_VOL_L));
+}
+
+// mute: спуск до шага 1, вход отключается вместе с возвратом L, R, подъёма нет
+void test_keys_mute() {
+  uint8_t vol = stateGet().volume;
+  uint32_t t = replayNowMs();
+  replayIrNec(t + 10, IR_MUTE);
+  wireStruct w = wire("mute", t + 500);
+  TEST_ASSERT_TRUE(stateGet().isMute);
+  TEST_ASSERT_EQUAL(vol, w.tr);
+  TEST_ASSERT_EQUAL((vol - 1) * BURST_VOL + BURST_INPUT, w.bytes);
+  TEST_ASSERT_EQUAL_HEX8(MCU_INPUT_MUTE, simI2cReg(MCU_ADR, MCU_REG_INPUT));
+}
+
+// грязные регистры через MCU_MERGE_GAP чистых - одна посылка, дальше - две
+void test_merge_bytes_on_wire() {
+  uint32_t tr = simI2cTransactions(), bytes = simI2cBytes();
+  regs[MCU_REG_VOL_L]++;
+  regs[MCU_REG_MODE]++;
+  mcuWrite(regs);
+  tick(20);
+  TEST_ASSERT_EQUAL(1, simI2cTransactions() - tr);
+  TEST_ASSERT_EQUAL(1 + 1 + 4, simI2cBytes() - bytes);  // SLA+W, субадрес, регистры 0..3
+  assertRegs();
+
+  tr = simI2cTransactions();
+  bytes = simI2cBytes();
+  regs[MCU_REG_VOL_L]++;
+  regs[MCU_REG_EQ]++;
+  mcuWrite(regs);
+  tick(20);
+  TEST_ASSERT_EQUAL(2, simI2cTransactions() - tr);
+  TEST_ASSERT_EQUAL(2 * (1 + 1 + 1), simI2cBytes() - bytes);
+  assertRegs();
+}
+
+// состояния, пришедшие во время посылки, склеиваются в одно
+void test_burst_sends_last_state() {
+  mcuStatsStruct s = mcuGetStats();
+  uint32_t tr = simI2cTransactions(), bytes = simI2cBytes();
+  for (uint8_t n = 0; n < 5; n++) {
+    regs[MCU_REG_VOL_L]++;
+    regs[MCU_REG_VOL_R]++;
+    mcuWrite(regs);
+  }
+  tick(20);
+  TEST_ASSERT_EQUAL(3, mcuGetStats().merged - s.merged);  // первое ушло сразу, второе ждало
+  TEST_ASSERT_EQUAL(2, simI2cTransactions() - tr);       // первое состояние и последнее
+  TEST_ASSERT_EQUAL(2 * (1 + 1 + 2), simI2cBytes() - bytes);
+  assertRegs();
+}
+
+// вторая посылка начинается из mcuTick(), а не из TWI_vect в ожидании STOP
+void test_next_burst_from_tick() {
+  uint32_t tr = simI2cTransactions();
+  regs[MCU_REG_VOL_L]++;
+  regs[MCU_REG_EQ]++;
+  mcuWrite(regs);
+  simRunUs(5000);
+  TEST_ASSERT_EQUAL(1, simI2cTransactions() - tr);
+  TEST_ASSERT_TRUE(mcuBusy());
+  tick(20);
+  TEST_ASSERT_EQUAL(2, simI2cTransactions() - tr);
+  assertRegs();
+}
+
+// MCU не отвечает: после MCU_RETRIES попыток повторы редкие, сну они не мешают
+void test_nack_slow_retry() {
+  mcuStatsStruct s = mcuGetStats();
+  simI2cNack(MCU_ADR, 1, 1000);
+  regs[MCU_REG_INPUT]++;
+  mcuWrite(regs);
+  tick(MCU_RETRIES * (MCU_TIMEOUT_MS + 5));
+  TEST_ASSERT_FALSE(mcuBusy());
+  TEST_ASSERT_EQUAL(MCU_RETRIES, mcuGetStats().errors - s.errors);
+  TEST_ASSERT_EQUAL(1, mcuGetStats().gaveUp - s.gaveUp);
+  uint32_t tr = simI2cTransactions();
+  tick(MCU_SLOW_RETRY_MS * 2 + 50);
+  TEST_ASSERT_EQUAL(tr + 2, simI2cTransactions());
+  TEST_ASSERT_FALSE(mcuBusy());
+
+  // MCU включился: состояние доходит без нового mcuWrite()
+  simI2cNack(MCU_ADR, 1, 0);
+  tick(MCU_SLOW_RETRY_MS + 20);
+  TEST_ASSERT_FALSE(mcuBusy());
+  assertRegs();
+  TEST_ASSERT_EQUAL(1, mcuGetStats().gaveUp - s.gaveUp);
+}
+
+int main() {
+  replayBoot();
+  replayRunFor(100);
+  UNITY_BEGIN();
+  // сначала прошивка целиком, пока регистры совпадают с её состоянием
+  RUN_TEST(test_keys_unmute);
+  RUN_TEST(test_keys_encoder);
+  RUN_TEST(test_keys_mute);
+  RUN_TEST(test_merge_bytes_on_wire);
+  RUN_TEST(test_burst_sends_last_state);
+  RUN_TEST(test_next_burst_from_tick);
+  RUN_TEST(test_nack_slow_retry);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+// Действия пользователя, приглушение индикации и сон в mute.
+// Доля сна, пробуждения в секунду и оценка тока МК по ней: ток в активном
+// режиме и в power-save взяты типовыми из документации ATmega168 (16 МГц,
+// 5 В, BOD включён фьюзами Nano). Плата (стабилизатор, USB-UART, светодиоды)
+// сюда не входит.
+#include <unity.h>
+#include <stdio.h>
+#include "replay.h"
+#include "state.h"
+#include "power.h"
+#include "storage.h"
+
+#define I_ACTIVE_UA 9000   // активный режим, 16 МГц, 5 В
+#define I_SLEEP_UA  25     // power-save без часового кварца, BOD
+#define FOREIGN_IR 0x20DF10EF // код чужого пульта: будит, но ничего не меняет
+
+typedef struct {
+  uint64_t at;
+  uint64_t awake;
+} powerMarkStruct;
+
+// звук только что выключен, с этого момента считается окно. Прогон
+// перед ним идёт со звуком: МК не спит и входит в окно бодрствующим, а не
+// из sleep_cpu(), прерванного концом прошлого прогона
+static powerMarkStruct muteNow() {
+  stateSetMute(false);
+  replayRunFor(100);
+  stateSetMute(true);
+  replayLogClear();
+  powerMarkStruct m = {simNow(), simAwakeCycles()};
+  return m;
+}
+
+// пробуждений в секунду * 1000 и средний ток, мкА, с момента m. Пробуждения
+// берутся из лога модели: конец прогона тоже выводит МК из sleep_cpu(), и
+// powerStatsStruct.wakeups посчитает его лишний раз
+static void report(const char *name, const powerMarkStruct &m, uint32_t *wakeMilli, uint32_t *currentUa) {
+  uint64_t total = simNow() - m.at;
+  uint64_t awake = simAwakeCycles() - m.awake;
+  uint32_t wakeups = replayLogCount(" wake\n");
+  *wakeMilli = (uint64_t) wakeups * 1000 * SIM_HZ / total;
+  *currentUa = (awake * I_ACTIVE_UA + (total - awake) * I_SLEEP_UA) / total;
+  printf("  %-10s %4.1f s: awake %5.2f%%, %lu wakeups (%lu.%03lu/s), ~%lu uA\n", name, (double) total / SIM_HZ,
+         100.0 * awake / total, (unsigned long) wakeups, (unsigned long) (*wakeMilli / 1000),
+         (unsigned long) (*wakeMilli % 1000), (unsigned long) *currentUa);
+}
+
+void setUp() {
+  replayLogClear();
+}
+
+void tearDown() {}
+
+// поворот энкодера - действие пользователя, как и кнопка
+void test_turn_is_activity() {
+  stateSetMute(false);
+  replayRunFor(2000);
+  TEST_ASSERT_GREATER_OR_EQUAL(2000, powerIdleMs());
+  uint32_t t = replayNowMs();
+  replayEncoder(t + 10, 1, 200);
+  replayRun(t + 50);
+  TEST_ASSERT_LESS_THAN(50, powerIdleMs());
+}
+
+// изменение перед сном сначала ложится в EEPROM: во сне millis() стоит,
+// и STORAGE_DELAY_MS не истёк бы до пробуждения
+void test_sleep_waits_for_storage() {
+  uint32_t t = replayNowMs();
+  stateSetMute(true);
+  replayRun(t + STORAGE_DELAY_MS + POWER_IDLE_MS + 1000);
+  const char *log = replayLog();
+  const char *ee = strstr(log, "eeprom");
+  const char *sleep = strstr(log, "sleep");
+  TEST_ASSERT_NOT_NULL(ee);
+  TEST_ASSERT_NOT_NULL(sleep);
+  TEST_ASSERT_TRUE(ee < sleep);
+}
+
+// в mute без входов МК не просыпается: бодрствует, пока состояние ждёт
+// записи в EEPROM, и ещё POWER_IDLE_MS
+void test_idle_muted() {
+  powerMarkStruct m = muteNow();
+  replayRunFor(60000);
+  uint32_t wakeMilli, ua;
+  report("quiet", m, &wakeMilli, &ua);
+  TEST_ASSERT_EQUAL(0, wakeMilli);
+  uint64_t awakeMs = (simAwakeCycles() - m.awake) / SIM_CYCLES_MS(1);
+  TEST_ASSERT_UINT32_WITHIN(100, STORAGE_DELAY_MS + POWER_IDLE_MS, awakeMs);
+  TEST_ASSERT_LESS_THAN(I_ACTIVE_UA / 5, ua);
+}
+
+// чужой пульт раз в 10 с, первый кадр уже во сне: одно пробуждение на
+// кадр, после него POWER_IDLE_MS бодрствования
+void test_foreign_remote() {
+  powerMarkStruct m = muteNow();
+  uint32_t t = replayNowMs();
+  for (uint8_t i = 0; i < 6; i++) replayIrNec(t + 9000 + 10000UL * i, FOREIGN_IR);
+  replayRun(t + 60000);
+  uint32_t wakeMilli, ua;
+  report("ir / 10 s", m, &wakeMilli, &ua);
+  TEST_ASSERT_LESS_OR_EQUAL(100, wakeMilli); // не больше пробуждения на кадр
+  TEST_ASSERT_EQUAL(6, replayLogCount(" wake\n"));
+  uint64_t awakeMs = (simAwakeCycles() - m.awake) / SIM_CYCLES_MS(1);
+  TEST_ASSERT_LESS_OR_EQUAL(STORAGE_DELAY_MS + POWER_IDLE_MS + 6 * (POWER_IDLE_MS + 200), awakeMs);
+  TEST_ASSERT_LESS_THAN(I_ACTIVE_UA / 2, ua);
+}
+
+int main() {
+  replayLogStart(false);
+  replayBoot();
+  UNITY_BEGIN();
+  RUN_TEST(test_turn_is_activity);
+  RUN_TEST(test_sleep_waits_for_storage);
+  RUN_TEST(test_idle_muted);
+  RUN_TEST(test_foreign_remote);
+  return UNITY_END();
+}
@@ -0,0 +1,114 @@
+// Кадр профилировщика и остальной вывод в UART (env:native_prof, -D PROFILER).
+#include <unity.h>
+#include "replay.h"
+#include "protocol.h"
+#include "profiler.h"
+#include "state.h"
+
+static uint8_t buf[1024];
+
+void setUp() {
+  replayUart(buf, sizeof(buf));
+}
+
+void tearDown() {}
+
+// разобрать поток на кадры, вернёт число целых кадров или -1 при разрыве
+static int frames(const uint8_t *p, uint16_t n, uint8_t *cmds, uint8_t max) {
+  uint16_t i = 0;
+  int count = 0;
+  while (i < n) {
+    if (p[i] != PROTO_START || i + 2 >= n) return -1;
+    uint8_t len = p[i + 1];
+    if (i + 2 + len >= n) return -1;
+    uint8_t sum = 0;
+    for (uint16_t j = i; j < i + 2 + len; j++) sum += p[j];
+    if (sum != p[i + 2 + len]) return -1;
+    if (count < max) cmds[count] = p[i + 2];
+    count++;
+    i += len + 3;
+  }
+  return count;
+}
+
+static int indexOf(const uint8_t *cmds, int n, uint8_t cmd) {
+  for (int i = 0; i < n; i++) {
+    if (cmds[i] == cmd) return i;
+  }
+  return -1;
+}
+
+// ответ на команду, пришедшую следом за PROTO_PROF_DUMP, и события телеметрии
+// не врезаются в середину кадра PROTO_PROF
+void test_dump_is_not_interleaved() {
+  uint32_t t = replayNowMs();
+  uint8_t rx[] = {PROTO_START, 1, PROTO_PROF_DUMP, PROTO_START + 1 + PROTO_PROF_DUMP,
+                  PROTO_START, 1, PROTO_GET_STATE, PROTO_START + 1 + PROTO_GET_STATE};
+  replaySerial(t + 10, rx, sizeof(rx));
+  replayRun(t + 11);
+  TEST_ASSERT_TRUE(profBusy());
+  stateSetVolume(stateGet().volume + 1);
+  replayRun(t + 100);
+  TEST_ASSERT_FALSE(profBusy());
+
+  uint16_t n = replayUart(buf, sizeof(buf));
+  uint8_t cmds[16];
+  int count = frames(buf, n, cmds, sizeof(cmds));
+  TEST_ASSERT_GREATER_OR_EQUAL(3, count);
+  int prof = indexOf(cmds, count, PROTO_PROF);
+  int state = indexOf(cmds, count, PROTO_STATE);
+  int event = indexOf(cmds, count, PROTO_EVENT);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, prof);
+  TEST_ASSERT_GREATER_THAN(prof, state);
+  TEST_ASSERT_GREATER_THAN(prof, event);
+  TEST_ASSERT_EQUAL(0, protoGetStats().txDropped);
+}
+
+// число замеров стадии в кадре PROTO_PROF (сумма гистограммы)
+static uint32_t stageCount(const uint8_t *data, uint8_t stage) {
+  const uint8_t *h = data + 2 + stage * (2 + PROF_BUCKETS) * 2 + 4;
+  uint32_t sum = 0;
+  for (uint8_t b = 0; b < PROF_BUCKETS; b++) sum += h[2 * b] | (h[2 * b + 1] << 8);
+  return sum;
+}
+
+// кадр уходит несколько миллисекунд, и всё это время loop() крутится;
+// стадии идут в кадре по порядку, так что если замеры не заморожены,
+// PROF_LOOP в хвосте кадра насчитает больше проходов, чем PROF_ENCODER в начале
+void test_dump_is_snapshot() {
+  uint32_t t = replayNowMs();
+  replayRun(t + 50);
+  replayUart(buf, sizeof(buf));
+  uint8_t rx[] = {PROTO_START, 1, PROTO_PROF_DUMP, PROTO_START + 1 + PROTO_PROF_DUMP};
+  replaySerial(t + 60, rx, sizeof(rx));
+  replayRun(t + 150);
+  TEST_ASSERT_FALSE(profBusy());
+
+  uint16_t n = replayUart(buf, sizeof(buf));
+  const uint8_t *data = NULL;
+  for (uint16_t i = 0; i + 4 < n; i++) {
+    if (buf[i] == PROTO_START && buf[i + 2] == PROTO_PROF) {
+      data = buf + i + 3;
+      TEST_ASSERT_TRUE(i + 3 + buf[i + 1] <= n);
+      break;
+    }
+  }
+  TEST_ASSERT_NOT_NULL(data);
+  TEST_ASSERT_EQUAL(PROF_STAGES, data[0]);
+  TEST_ASSERT_EQUAL(PROF_BUCKETS, data[1]);
+  uint32_t loops = stageCount(data, PROF_ENCODER);
+  TEST_ASSERT_GREATER_THAN(0, loops);
+  // проход, в котором пришла команда, успевает записать часть стадий
+  for (uint8_t s = 1; s < PROF_STAGES; s++) {
+    TEST_ASSERT_UINT32_WITHIN(1, loops, stageCount(data, s));
+  }
+}
+
+int main() {
+  replayBoot();
+  replayRunFor(100);
+  UNITY_BEGIN();
+  RUN_TEST(test_dump_is_not_interleaved);
+  RUN_TEST(test_dump_is_snapshot);
+  return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// Протокол по UART на модели: хост шлёт кадры в RX прошивки, ответы из TX
+// разбираются здесь же, с проверкой длины и суммы каждого кадра.
+// Кадры телеметрии (PROTO_EVENT) между ответами пропускаются.
+#include <unity.h>
+#include "replay.h"
+#include "state.h"
+#include "protocol.h"
+
+#define STATS_FRAMES     4 // слова PROTO_STATS, см. serialCommand() в main.cpp
+#define STATS_BAD_FRAMES 5
+
+typedef struct {
+  uint8_t cmd;
+  uint8_t len;
+  uint8_t data[PROTO_MAX_REPLY];
+} frameStruct;
+
+static uint8_t rx[512];
+static uint16_t rxLen;
+static bool badWire;              // с линии пришёл оборванный кадр или неверная сумма
+
+void setUp() {
+  replayRunFor(20);
+  replayUart(rx, sizeof(rx));
+  rxLen = 0;
+  badWire = false;
+}
+
+void tearDown() {
+  TEST_ASSERT_FALSE(badWire);
+}
+
+static uint8_t frame(uint8_t *f, uint8_t cmd, const uint8_t *data, uint8_t len) {
+  uint8_t n = 0;
+  f[n++] = PROTO_START;
+  f[n++] = len + 1;
+  f[n++] = cmd;
+  for (uint8_t i = 0; i < len; i++) f[n++] = data[i];
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < n; i++) sum += f[i];
+  f[n++] = sum;
+  return n;
+}
+
+// все ответы, ушедшие к этому моменту, кроме событий; кадры обязаны быть целыми
+static uint8_t replies(frameStruct *out, uint8_t max) {
+  rxLen += replayUart(rx + rxLen, sizeof(rx) - rxLen);
+  uint8_t n = 0;
+  uint16_t i = 0;
+  while (i < rxLen) {
+    uint8_t len = rx[i + 1];
+    uint8_t sum = 0;
+    for (uint8_t k = 0; k < len + 2 && i + k < rxLen; k++) sum += rx[i + k];
+    if (rx[i] != PROTO_START || len == 0 || i + len + 3 > rxLen || sum != rx[i + len + 2]) {
+      badWire = true;
+      break;
+    }
+    if (rx[i + 2] != PROTO_EVENT && n < max) {
+      out[n].cmd = rx[i + 2];
+      out[n].len = len - 1;
+      memcpy(out[n].data, rx + i + 3, len - 1);
+      n++;
+    }
+    i += len + 3;
+  }
+  rxLen = 0;
+  return n;
+}
+
+// команда и единственный ответ на неё
+static frameStruct exchange(uint8_t cmd, const uint8_t *data = NULL, uint8_t len = 0) {
+  uint32_t t = replayNowMs();
+  replayCommand(t + 5, cmd, data, len);
+  replayRun(t + 30);
+  frameStruct f[2];
+  if (replies(f, 2) != 1) f[0].cmd = 0; // ответа нет или их несколько
+  return f[0];
+}
+
+static uint16_t statsWord(uint8_t i) {
+  frameStruct f = exchange(PROTO_GET_STATS);
+  if (f.cmd != PROTO_STATS) return 0xFFFF;
+  return f.data[2 * i] | f.data[2 * i + 1] << 8;
+}
+
+void test_set_then_get_state() {
+  uint8_t set[] = {PROTO_F_VOLUME | PROTO_F_BASS | PROTO_F_MUTE, 17, (uint8_t) -3, 0, 0, 0};
+  frameStruct f = exchange(PROTO_SET_STATE, set, sizeof(set));
+  TEST_ASSERT_EQUAL_HEX8(PROTO_STATE, f.cmd);
+  TEST_ASSERT_EQUAL(5, f.len);
+  TEST_ASSERT_EQUAL(17, f.data[0]);
+  TEST_ASSERT_EQUAL(-3, (int8_t) f.data[1]);
+  TEST_ASSERT_EQUAL(0, f.data[4]);
+
+  frameStruct g = exchange(PROTO_GET_STATE);
+  TEST_ASSERT_EQUAL_HEX8(PROTO_STATE, g.cmd);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(f.data, g.data, 5);
+  TEST_ASSERT_EQUAL(17, stateGet().volume);
+}
+
+void test_stats_counts_frames() {
+  uint16_t a = statsWord(STATS_FRAMES);
+  uint16_t b = statsWord(STATS_FRAMES);
+  TEST_ASSERT_EQUAL(a + 1, b);
+  frameStruct f = exchange(PROTO_GET_STATS);
+  TEST_ASSERT_EQUAL(PROTO_MAX_REPLY, f.len);
+}
+
+void test_nak() {
+  frameStruct f = exchange(0x7E);
+  TEST_ASSERT_EQUAL_HEX8(PROTO_NAK, f.cmd);
+  TEST_ASSERT_EQUAL(1, f.len);
+  TEST_ASSERT_EQUAL_HEX8(0x7E, f.data[0]);
+
+  uint8_t shortSet[] = {PROTO_F_VOLUME, 5};
+  f = exchange(PROTO_SET_STATE, shortSet, sizeof(shortSet));
+  TEST_ASSERT_EQUAL_HEX8(PROTO_NAK, f.cmd);
+  TEST_ASSERT_EQUAL_HEX8(PROTO_SET_STATE, f.data[0]);
+}
+
+// испорченная сумма и длина больше буфера: ответа нет, кадр считается плохим
+void test_bad_frames_dropped() {
+  uint16_t bad = statsWord(STATS_BAD_FRAMES);
+  uint8_t f[PROTO_MAX_DATA + 4];
+  uint8_t n = frame(f, PROTO_GET_STATE, NULL, 0);
+  f[n - 1] ^= 1;
+  uint32_t t = replayNowMs();
+  replaySerial(t + 5, f, n);
+  static const uint8_t tooLong[] = {PROTO_START, PROTO_MAX_DATA + 2};
+  replaySerial(t + 10, tooLong, sizeof(tooLong));
+  replayRun(t + 40);
+  frameStruct r[2];
+  TEST_ASSERT_EQUAL(0, replies(r, 2));
+  TEST_ASSERT_EQUAL(bad + 2, statsWord(STATS_BAD_FRAMES));
+}
+
+// кадр по байту с паузами, затем мусор и два кадра одной посылкой:
+// ответы идут по порядку команд
+void test_split_and_burst() {
+  uint8_t buf[64];
+  uint8_t n = frame(buf, PROTO_GET_STATE, NULL, 0);
+  uint32_t t = replayNowMs() + 5;
+  for (uint8_t i = 0; i < n; i++) replaySerial(t + 3 * i, buf + i, 1);
+  uint8_t m = 0;
+  buf[m++] = 0x00;
+  buf[m++] = 0x5A;
+  m += frame(buf + m, 0x7D, NULL, 0);
+  m += frame(buf + m, PROTO_GET_STATS, NULL, 0);
+  replaySerial(t + 3 * n + 5, buf, m);
+  replayRun(t + 3 * n + 40);
+  frameStruct r[4];
+  TEST_ASSERT_EQUAL(3, replies(r, 4));
+  TEST_ASSERT_EQUAL_HEX8(PROTO_STATE, r[0].cmd);
+  TEST_ASSERT_EQUAL_HEX8(PROTO_NAK, r[1].cmd);
+  TEST_ASSERT_EQUAL_HEX8(0x7D, r[1].data[0]);
+  TEST_ASSERT_EQUAL_HEX8(PROTO_STATS, r[2].cmd);
+}
+
+int main() {
+  replayBoot();
+  UNITY_BEGIN();
+  RUN_TEST(test_set_then_get_state);
+  RUN_TEST(test_stats_counts_frames);
+  RUN_TEST(test_nak);
+  RUN_TEST(test_bad_frames_dropped);
+  RUN_TEST(test_split_and_burst);
+  return UNITY_END();
+}
@@ -0,0 +1,108 @@
+// Плавное переключение входа и mute: громкость идёт по шагам кривой
+// volcurve.h, без кодов между ними, и не поднимается, если звука нет.
+// Регистры MCU снимаются с шины каждую миллисекунду, шаг рампы 2 мс.
+#include <unity.h>
+#include "replay.h"
+#include "state.h"
+#include "mcu.h"
+#include "ramp.h"
+#include "volcurve.h"
+
+#define INPUT_AUX B00000000
+#define INPUT_PC  B00100000
+
+typedef struct {
+  uint16_t ms;        // до конца рампы
+  uint8_t offCurve;   // кодов громкости не из таблицы
+  uint8_t lowest;     // самый тихий шаг за время рампы
+  uint8_t firstOn;    // шаг громкости, с которым включился вход
+} rampRunStruct;
+
+static uint8_t volStep(uint8_t code) {
+  for (uint8_t v = 0; v <= MAX_VOLUME; v++) {
+    if (volToReg(v) == code) return v;
+  }
+  return 0xFF;
+}
+
+static rampRunStruct run() {
+  rampRunStruct r = {0, 0, 0xFF, 0xFF};
+  uint8_t input = simI2cReg(MCU_ADR, MCU_REG_INPUT);
+  replayRunFor(1); // состояние доходит до rampWrite() в stateTick()
+  while (r.ms < 1000) {
+    uint8_t code = simI2cReg(MCU_ADR, MCU_REG_VOL_L);
+    uint8_t step = volStep(code);
+    if (step == 0xFF || code != simI2cReg(MCU_ADR, MCU_REG_VOL_R)) r.offCurve++;
+    else if (step < r.lowest) r.lowest = step;
+    uint8_t now = simI2cReg(MCU_ADR, MCU_REG_INPUT);
+    if (now != input && r.firstOn == 0xFF) r.firstOn = step;
+    if (!rampActive() && !mcuBusy()) break;
+    replayRunFor(1);
+    r.ms++;
+  }
+  return r;
+}
+
+static void settle(int volume, bool mute) {
+  stateSetVolume(volume);
+  stateSetMute(mute);
+  replayRunFor(300);
+  TEST_ASSERT_FALSE(rampActive());
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// вниз до шага 1, вход, обратно вверх: только коды из таблицы
+void test_input_switch_on_curve() {
+  settle(30, false);
+  stateSetInput(stateGet().inputCh == AUX ? PC : AUX);
+  rampRunStruct r = run();
+  TEST_ASSERT_EQUAL(0, r.offCurve);
+  TEST_ASSERT_EQUAL(1, r.lowest);
+  TEST_ASSERT_EQUAL(1, r.firstOn);
+  TEST_ASSERT_EQUAL_HEX8(volToReg(30), simI2cReg(MCU_ADR, MCU_REG_VOL_L));
+  TEST_ASSERT_EQUAL_HEX8(stateGet().inputCh == AUX ? INPUT_AUX : INPUT_PC, simI2cReg(MCU_ADR, MCU_REG_INPUT));
+  // 29 шагов вниз, переключение и 29 вверх
+  TEST_ASSERT_UINT32_WITHIN(4, 59 * RAMP_STEP_US / 1000, r.ms);
+}
+
+// на громкости 0 вход переключается сразу, громкость не трогается
+void test_switch_at_zero_stays_silent() {
+  settle(0, false);
+  uint32_t tr = simI2cTransactions();
+  stateSetInput(stateGet().inputCh == AUX ? PC : AUX);
+  rampRunStruct r = run();
+  TEST_ASSERT_EQUAL(0, r.offCurve);
+  TEST_ASSERT_EQUAL(0, r.lowest);
+  TEST_ASSERT_EQUAL_HEX8(VOL_ATT_MUTE, simI2cReg(MCU_ADR, MCU_REG_VOL_L));
+  TEST_ASSERT_EQUAL(1, simI2cTransactions() - tr);
+}
+
+// после mute подниматься незачем, после снятия mute подъём с шага 1
+void test_mute_ramps_one_way() {
+  settle(20, false);
+  stateSetMute(true);
+  rampRunStruct r = run();
+  TEST_ASSERT_EQUAL(0, r.offCurve);
+  TEST_ASSERT_EQUAL_HEX8(MCU_INPUT_MUTE, simI2cReg(MCU_ADR, MCU_REG_INPUT));
+  TEST_ASSERT_UINT32_WITHIN(4, 20 * RAMP_STEP_US / 1000, r.ms);
+
+  stateSetMute(false);
+  r = run();
+  TEST_ASSERT_EQUAL(0, r.offCurve);
+  TEST_ASSERT_EQUAL(1, r.firstOn);
+  TEST_ASSERT_EQUAL_HEX8(volToReg(20), simI2cReg(MCU_ADR, MCU_REG_VOL_L));
+  TEST_ASSERT_UINT32_WITHIN(4, 20 * RAMP_STEP_US / 1000, r.ms);
+}
+
+int main() {
+  replayBoot();
+  replayRunFor(100);
+  UNITY_BEGIN();
+  RUN_TEST(test_input_switch_on_curve);
+  RUN_TEST(test_switch_at_zero_stays_silent);
+  RUN_TEST(test_mute_ramps_one_way);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+// Прогон прошивки на модели: входы с пульта, энкодера и UART доходят до
+// регистров MCU (I2C), индикации и ответов протокола.
+// Прошивка стартует один раз на весь набор, тесты идут по порядку.
+#include <unity.h>
+#include "replay.h"
+#include "state.h"
+#include "mcu.h"
+#include "protocol.h"
+
+#define IR_MUTE    0x00FB2AD5
+#define IR_VOL_UP  0x00FB906F
+
+void setUp() {
+  replayLogClear();
+}
+
+void tearDown() {}
+
+// пустой EEPROM: состояние по умолчанию, звук выключен, все регистры за одну посылку
+void test_boot() {
+  replayBoot();
+  replayRunFor(100);
+  TEST_ASSERT_TRUE(stateGet().isMute);
+  TEST_ASSERT_EQUAL(1, simI2cTransactions());
+  TEST_ASSERT_EQUAL_HEX8(B11100000, simI2cReg(MCU_ADR, MCU_REG_INPUT));
+  simDisplayStruct d = simDisplay();
+  TEST_ASSERT_EQUAL('-', simGlyphChar(d.seg[0]));
+  TEST_ASSERT_EQUAL('-', simGlyphChar(d.seg[1]));
+}
+
+void test_ir_mute_unmutes() {
+  uint32_t t = replayNowMs();
+  replayIrNec(t + 10, IR_MUTE);
+  replayRun(t + 600);
+  TEST_ASSERT_FALSE(stateGet().isMute);
+  TEST_ASSERT_EQUAL_HEX8(B00000000, simI2cReg(MCU_ADR, MCU_REG_INPUT));
+  TEST_ASSERT_TRUE(replayLogHas("disp 20"));
+}
+
+void test_ir_volume_and_repeat() {
+  uint8_t vol = stateGet().volume;
+  uint32_t t = replayNowMs();
+  // повторы идут каждые 110 мс, прошивка берёт не чаще раза в 200 мс
+  replayIrNec(t + 10, IR_VOL_UP);
+  for (uint8_t i = 1; i <= 4; i++) replayIrRepeat(t + 10 + 110 * i);
+  replayRun(t + 700);
+  TEST_ASSERT_EQUAL(vol + 2, stateGet().volume);
+}
+
+void test_encoder_turns() {
+  uint8_t vol = stateGet().volume;
+  uint32_t t = replayNowMs();
+  // медленно, без ускорения
+  replayEncoder(t + 10, -2, 200);
+  replayRun(t + 600);
+  TEST_ASSERT_EQUAL(vol - 2, stateGet().volume);
+}
+
+void test_serial_get_state() {
+  uint8_t buf[64];
+  replayUart(buf, sizeof(buf));
+  uint32_t t = replayNowMs();
+  replayCommand(t + 10, PROTO_GET_STATE);
+  replayRun(t + 50);
+  uint16_t n = replayUart(buf, sizeof(buf));
+  // перед ответом могут уйти события телеметрии, кадры идут целиком
+  uint16_t i = 0;
+  while (i + 3 < n && buf[i + 2] != PROTO_STATE) i += buf[i + 1] + 3;
+  TEST_ASSERT_LESS_THAN(n, i + 3);
+  TEST_ASSERT_EQUAL_HEX8(PROTO_START, buf[i]);
+  TEST_ASSERT_EQUAL(stateGet().volume, buf[i + 3]);
+}
+
+// обучение: кадр длиннее RAW_BUFFER_LENGTH (Panasonic, 48 бит) не теряется
+// молча, индикация показывает LONG, обучаемая кнопка та же
+void test_learn_long_frame() {
+  uint32_t t = replayNowMs();
+  replayClick(t + 10);
+  replayButton(t + 300, true);
+  replayButton(t + 1500, false);
+  replayRun(t + 1600);
+  TEST_ASSERT_TRUE(replayLogHas("disp L1"));
+
+  uint16_t us[1 + 2 + 2 * 48];
+  uint8_t n = 0;
+  us[n++] = 3502;
+  us[n++] = 1750;
+  for (uint8_t i = 0; i < 48; i++) {
+    us[n++] = 502;
+    us[n++] = i & 1 ? 1244 : 400;
+  }
+  us[n++] = 502;
+  replayLogClear();
+  t = replayNowMs();
+  replayIrRaw(t + 10, us, n);
+  replayRun(t + 2500);
+  TEST_ASSERT_TRUE(replayLogHas("disp  L"));
+  TEST_ASSERT_TRUE(replayLogHas("disp NG"));
+  TEST_ASSERT_TRUE(replayLogHas("disp L1"));   // после строки - та же кнопка
+  TEST_ASSERT_FALSE(replayLogHas("disp L2"));
+
+  replayClick(replayNowMs() + 10);
+  replayRun(replayNowMs() + 300);
+}
+
+void test_parse_rejects_garbage() {
+  TEST_ASSERT_EQUAL(0, replayParse("20 knob left\n"));
+  TEST_ASSERT_EQUAL(500, replayParse("# comment\n\n100 btn click\n500 end\n900 btn click\n"));
+  replayRun(replayNowMs() + 10);
+}
+
+int main() {
+  replayLogStart(false);
+  UNITY_BEGIN();
+  RUN_TEST(test_boot);
+  RUN_TEST(test_ir_mute_unmutes);
+  RUN_TEST(test_ir_volume_and_repeat);
+  RUN_TEST(test_encoder_turns);
+  RUN_TEST(test_serial_get_state);
+  RUN_TEST(test_learn_long_frame);
+  RUN_TEST(test_parse_rejects_garbage);
+  return UNITY_END();
+}
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""Утилита для работы с усилителем по Serial (протокол из include/protocol.h).
+
+  solo_ctl.py PORT get                  - текущее состояние
+  solo_ctl.py PORT set поле=значение... - volume, bass, treble, input (aux/pc), mute (0/1)
+  solo_ctl.py PORT stats                - счётчики I2C и протокола
+  solo_ctl.py PORT prof                 - статистика профилировщика (сборка с -D PROFILER)
+  solo_ctl.py PORT events               - печатать события, пока не прервут
+"""
+import struct
+import sys
+import time
+
+import serial  # pyserial
+
+BAUD = 115200
+
+PROTO_START = 0xA5
+PROTO_GET_STATE = 0x01
+PROTO_SET_STATE = 0x02
+PROTO_GET_STATS = 0x03
+PROTO_PROF_DUMP = 0x04
+PROTO_STATE = 0x81
+PROTO_STATS = 0x83
+PROTO_PROF = 0x84
+PROTO_EVENT = 0x85
+PROTO_NAK = 0xFF
+
+FIELDS = ["volume", "bass", "treble", "input", "mute"]
+STATS_NAMES = ["i2c done", "i2c errors", "i2c timeouts", "i2c merged",
+               "rx frames", "rx bad frames", "tx dropped", "events dropped",
+               "sleeps", "wakeups", "enc lost", "display load, 0.1%",
+               "ir overflows", "ir dropped", "i2c slow retries"]
+EVENT_UNKNOWN_CODE = 1
+EVENT_STATE = 2
+PROF_STAGE_NAMES = ["encoder", "ir", "sync", "display", "loop"]
+TICK_US = 0.5
+
+
+def read_exact(port, n):
+    data = port.read(n)
+    if len(data) != n:
+        raise IOError("timeout")
+    return data
+
+
+def send(port, cmd, data=b""):
+    frame = bytes([PROTO_START, len(data) + 1, cmd]) + data
+    port.write(frame + bytes([sum(frame) & 0xFF]))
+
+
+def receive(port, want):
+    """Вернуть данные первого целого кадра с командой want."""
+    while True:
+        if read_exact(port, 1)[0] != PROTO_START:
+            continue  # отладочный текст или мусор до начала кадра
+        length = read_exact(port, 1)[0]
+        body = read_exact(port, length)
+        crc = read_exact(port, 1)[0]
+        if (PROTO_START + length + sum(body)) & 0xFF != crc:
+            continue
+        if body[0] == PROTO_NAK:
+            raise IOError("command 0x%02X rejected" % body[1])
+        if body[0] == want:
+            return body[1:]
+
+
+def print_state(data):
+    volume, bass, treble, inp, mute = struct.unpack("<Bbbbb", data)
+    print("volume %d  bass %d  treble %d  input %s  mute %d"
+          % (volume, bass, treble, "pc" if inp else "aux", mute))
+
+
+def get(port, args):
+    send(port, PROTO_GET_STATE)
+    print_state(receive(port, PROTO_STATE))
+
+
+def set_(port, args):
+    values = [0] * 5
+    mask = 0
+    for arg in args:
+        name, value = arg.split("=", 1)
+        i = FIELDS.index(name)
+        if name == "input":
+            value = {"aux": 0, "pc": 1}.get(value, value)
+        values[i] = int(value)
+        mask |= 1 << i
+    send(port, PROTO_SET_STATE, struct.pack("<BBbbBB", mask, *values))
+    print_state(receive(port, PROTO_STATE))
+
+
+def stats(port, args):
+    send(port, PROTO_GET_STATS)
+    data = receive(port, PROTO_STATS)
+    for name, value in zip(STATS_NAMES, struct.unpack("<%dH" % (len(data) // 2), data)):
+        print("%-20s %d" % (name, value))
+
+
+def prof(port, args):
+    send(port, PROTO_PROF_DUMP)
+    data = receive(port, PROTO_PROF)
+    stages, buckets = data[0], data[1]
+    fmt = "<%dH" % (2 + buckets)
+    size = struct.calcsize(fmt)
+    for i in range(stages):
+        row = struct.unpack_from(fmt, data, 2 + i * size)
+        name = PROF_STAGE_NAMES[i] if i < len(PROF_STAGE_NAMES) else str(i)
+        if row[0] == 0xFFFF:
+            print("%-8s -" % name)
+            continue
+        hist = " ".join("%5d" % h for h in row[2:])
+        print("%-8s min %7.1f us  max %7.1f us  | %s" % (name, row[0] * TICK_US, row[1] * TICK_US, hist))
+    edges = ["<%d" % (8 << i) for i in range(buckets - 1)] + [">=%d" % (8 << (buckets - 2))]
+    print("%-8s %35s | %s" % ("", "buckets, us:", " ".join("%5s" % e for e in edges)))
+
+
+def events(port, args):
+    while True:
+        try:
+            data = receive(port, PROTO_EVENT)
+        except IOError:
+            continue  # тишина на линии
+        kind, protocol, code, ms = struct.unpack("<BbII", data)
+        if kind == EVENT_STATE:
+            volume, bass, treble, flags = struct.unpack("<Bbbb", struct.pack("<I", code))
+            changed = ",".join(f for i, f in enumerate(FIELDS) if protocol & (1 << i))
+            print("%10.3f s  state %-20s volume %d  bass %d  treble %d  input %s  mute %d"
+                  % (ms / 1000.0, changed, volume, bass, treble,
+                     "pc" if flags & 1 else "aux", flags >> 1 & 1))
+        elif kind == EVENT_UNKNOWN_CODE:
+            print("%10.3f s  unknown code   protocol %d  code 0x%08X" % (ms / 1000.0, protocol, code))
+
+
+COMMANDS = {"get": get, "set": set_, "stats": stats, "prof": prof, "events": events}
+
+
+def main():
+    if len(sys.argv) < 3 or sys.argv[2] not in COMMANDS:
+        print(__doc__)
+        return 1
+    with serial.Serial(sys.argv[1], BAUD, timeout=2) as port:
+        time.sleep(2)  # открытие порта перезагружает Nano, ждём загрузчик
+        port.reset_input_buffer()
+        COMMANDS[sys.argv[2]](port, sys.argv[3:])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())